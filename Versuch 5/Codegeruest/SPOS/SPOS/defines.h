@@ -32,17 +32,17 @@
 //----------------------------------------------------------------------------
 
 //! The current id of the exercise (this must be changed every two weeks).
-#define VERSUCH 4
+#define VERSUCH 5
 
 //----------------------------------------------------------------------------
 // System constants
 //----------------------------------------------------------------------------
 
-#define HEAP_OFFSET 245
-
 /*!
  *  Maximum number of processes that can be running at the same time
- *  (may be nothing > 8).
+ *  (may be nothing > 32).
+ *  More than 8 processes switch the heap maps to one byte per entry, which
+ *  leaves less of each heap for the actual data.
  *  This number includes the idle proc, although it is considered a system proc.
  *  The idle proc. has always id 0. The highest ID is MAX_NUMBER_OF_PROCESSES-1.
  */
@@ -67,6 +67,35 @@
 //! Number to specify an invalid program.
 #define INVALID_PROGRAM             255
 
+//! Program ID of the task manager, which is started with Enter+ESC
+#define TASKMAN_PROGRAM             MAX_NUMBER_OF_PROGRAMS
+
+//! Priority of the task manager process
+#define TASKMAN_PRIORITY            255
+
+//! Number of scheduling strategies that can be registered at runtime
+#define OS_CUSTOM_STRATEGY_COUNT    2
+
+//! Number of context switches kept in the trace (a power of two)
+#define OS_TRACE_LENGTH             16
+
+/*!
+ *  If defined (to one of the OS_SS_* strategies), the scheduler always uses
+ *  this strategy. The strategy switch in the scheduler then reduces to a
+ *  single direct call and the other strategies are removed by the linker
+ *  (--gc-sections). If undefined, the strategy may be changed at runtime.
+ */
+//#define OS_FIXED_SCHEDULING_STRATEGY OS_SS_ROUND_ROBIN
+
+//! Default compare value of timer 2 and thus the length of a time slice (~3 ms)
+#define SCHEDULER_TICK_COMPARE      60
+
+/*!
+ *  If set to 1, the idle process puts the MCU to sleep instead of polling and
+ *  the scheduler stretches the tick to the maximum while only idle is ready.
+ */
+#define OS_TICKLESS_IDLE            1
+
 //----------------------------------------------------------------------------
 // Stack constants
 //----------------------------------------------------------------------------
@@ -77,8 +106,25 @@
 //! The scheduler's stack size
 #define STACK_SIZE_ISR              192
 
-//! The stack size of a process
-#define STACK_SIZE_PROC             (((AVR_MEMORY_SRAM / 2) - STACK_SIZE_MAIN - STACK_SIZE_ISR) / MAX_NUMBER_OF_PROCESSES)
+/*!
+ *  The size of the memory region all process stacks are allocated from.
+ *  Everything between the globals and this region is used by the internal
+ *  heap, so shrinking it enlarges the internal heap.
+ */
+#define STACK_SIZE_PROCS            ((AVR_MEMORY_SRAM / 2) - STACK_SIZE_MAIN - STACK_SIZE_ISR)
+
+//! The default stack size of a process (used by os_exec)
+#define STACK_SIZE_PROC             (STACK_SIZE_PROCS / MAX_NUMBER_OF_PROCESSES)
+
+//! The stack size of the task manager process
+#define STACK_SIZE_TASKMAN          224
+
+/*!
+ *  The smallest stack size of a process. A context switch alone pushes 35
+ *  bytes (32 registers, SREG and the return address), so this leaves about as
+ *  much again for the program and its calls.
+ */
+#define STACK_SIZE_PROC_MIN         96
 
 //! The bottom of the main stack. That is the highest address.
 #define BOTTOM_OF_MAIN_STACK        (AVR_SRAM_LAST)
@@ -89,7 +135,58 @@
 //! The bottom of the memory chunks for all process stacks. That is the highest address.
 #define BOTTOM_OF_PROCS_STACK       (BOTTOM_OF_ISR_STACK - STACK_SIZE_ISR)
 
-//! The bottom of the memory chunk with number PID.
-#define PROCESS_STACK_BOTTOM(PID)   (BOTTOM_OF_PROCS_STACK - ((PID) * STACK_SIZE_PROC))
+//! The top of the memory chunks for all process stacks. That is the lowest address.
+#define TOP_OF_PROCS_STACK          (BOTTOM_OF_PROCS_STACK - STACK_SIZE_PROCS + 1)
+
+/*!
+ *  Upper bound of the size of the internal heap (including its map). The heap
+ *  takes everything between the globals and the process stacks, so its actual
+ *  size is determined at boot from the end of .data and .bss.
+ */
+#define INT_HEAP_SIZE_MAX           (TOP_OF_PROCS_STACK - AVR_SRAM_START)
+
+//----------------------------------------------------------------------------
+// Stack integrity checks
+//----------------------------------------------------------------------------
+
+/*!
+ *  XOR over the whole used stack of the process, computed on every suspend
+ *  and resume. Detects any modification of a suspended stack, but reads
+ *  every used byte twice per context switch.
+ */
+#define STACK_CHECK_FULL            0
+
+/*!
+ *  XOR over at most STACK_CHECK_WINDOW_SIZE bytes next to the saved stack
+ *  pointer, which covers the saved register context and the innermost
+ *  frames. Reads at most the window twice per context switch.
+ */
+#define STACK_CHECK_WINDOW          1
+
+/*!
+ *  A canary word at the top of every process stack that is checked on every
+ *  suspend and resume. Reads two bytes regardless of the stack depth, but
+ *  only detects stack overflows into the neighbouring stack.
+ */
+#define STACK_CHECK_CANARY          2
+
+//! The stack integrity check used by the scheduler
+#define STACK_CHECK_MODE            STACK_CHECK_FULL
+
+//! Number of bytes covered by STACK_CHECK_WINDOW
+#define STACK_CHECK_WINDOW_SIZE     48
+
+//! Value of the canary word used by STACK_CHECK_CANARY
+#define STACK_CANARY                0xA55A
+
+/*!
+ *  If set to 1, timer 1 counts processor cycles and the scheduler measures
+ *  how many cycles the stack checks of every context switch take. The average
+ *  is shown on the scheduler page of the CPU usage in the task manager, so the
+ *  modes above can be compared on the target with the same programs running.
+ *  No such measurements are recorded here.
+ *  Timer 1 is not used otherwise.
+ */
+#define OS_CYCLE_PROBE              0
 
 #endif
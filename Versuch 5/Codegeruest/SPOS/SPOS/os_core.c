@@ -10,8 +10,6 @@
 
 void os_initScheduler(void);
 
-extern uint8_t const __heap_start;
-
 //variable specially forcing the c/c++ linker to not initialize the variable so we can detect its initialized state
 uint8_t softResetDetector __attribute__ ((section (".noinit")));
 
@@ -41,7 +39,7 @@ void os_init_timer(void) {
     sbi(TCCR2B, CS21); // Prescaler 1024  1
     sbi(TCCR2B, CS20); // Prescaler 1024  1
     sbi(TIMSK2, OCIE2A); // Enable interrupt
-    OCR2A = 60;
+    OCR2A = SCHEDULER_TICK_COMPARE;
 
     // Init timer 0 with prescaler 256
     cbi(TCCR0B, CS00);
@@ -49,6 +47,11 @@ void os_init_timer(void) {
     sbi(TCCR0B, CS02);
 
     sbi(TIMSK0, TOIE0);
+
+#if OS_CYCLE_PROBE
+    // Init timer 1 without prescaler as a free running cycle counter
+    sbi(TCCR1B, CS10);
+#endif
 }
 
 /*!
@@ -130,11 +133,6 @@ void os_init(void) {
     os_checkSoftReset(1);
     delayMs(2000);
 	
-	// Maybe move this into a heap init function (Heap or SRAM drivers)
-	if ((uint16_t) (&__heap_start) > (AVR_SRAM_START + HEAP_OFFSET)) {
-		os_error("Increase Heap Offset!");
-	}
-	
 	initMemoryDevices();
 	
 	os_initHeaps();
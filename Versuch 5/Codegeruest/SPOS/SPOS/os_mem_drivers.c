@@ -3,6 +3,12 @@
 #include "os_spi.h"
 #include "util.h"
 #include "os_scheduler.h"
+#include "os_core.h"
+
+#include <string.h>
+
+//! End of .data and .bss, set by the linker
+extern uint8_t const __heap_start;
 
 void select_memory() {
 	cbi(PORTB, SPI_CS);
@@ -26,6 +32,14 @@ void transfer_adress(MemAddr addr) {
 }
 
 void initSRAM_internal(void) {
+	// The heap takes everything between the globals and the process stacks
+	MemAddr const start = (MemAddr) &__heap_start;
+	if (start >= TOP_OF_PROCS_STACK) {
+		os_error("Globals hit stacks");
+		return;
+	}
+	intSRAM__.start = start;
+	intSRAM__.size = TOP_OF_PROCS_STACK - start;
 }
 
 MemValue readSRAM_internal(MemAddr addr) {
@@ -36,48 +50,200 @@ void writeSRAM_internal(MemAddr addr, MemValue value) {
 	*((MemValue*) addr) = value;
 }
 
+void readBlockSRAM_internal(MemAddr addr, MemValue* buffer, uint16_t length) {
+	memcpy(buffer, (MemValue const*) addr, length);
+}
+
+void writeBlockSRAM_internal(MemAddr addr, MemValue const* buffer, uint16_t length) {
+	memcpy((MemValue*) addr, buffer, length);
+}
+
+void fillSRAM_internal(MemAddr addr, MemValue value, uint16_t length) {
+	memset((MemValue*) addr, value, length);
+}
+
 MemDriver intSRAM__ = {
 	.init = &initSRAM_internal,
 	.read = &readSRAM_internal,
 	.write = &writeSRAM_internal,
-	.start = AVR_SRAM_START + HEAP_OFFSET,
-	.size = AVR_MEMORY_SRAM / 2 - HEAP_OFFSET
+	.readBlock = &readBlockSRAM_internal,
+	.writeBlock = &writeBlockSRAM_internal,
+	.fill = &fillSRAM_internal
 };
 
+//! Transfer the external SRAM is kept selected for between two accesses
+typedef enum ExtStream {
+	EXT_STREAM_CLOSED,
+	EXT_STREAM_READ,
+	EXT_STREAM_WRITE
+} ExtStream;
+
+//! The open transfer of the external SRAM
+ExtStream extStream = EXT_STREAM_CLOSED;
+
+//! The address the open transfer of the external SRAM continues at
+MemAddr extStreamNext;
+
+//! Address of the byte of the external SRAM that was read last
+MemAddr extCacheAddr;
+
+//! Content of the byte at extCacheAddr, if extCacheValid is set
+MemValue extCacheValue;
+
+/*!
+ *  Whether extCacheValue holds the content of extCacheAddr. Heap maps read
+ *  the same byte for both entries it holds and before changing one of them,
+ *  which this spares a transfer each.
+ */
+bool extCacheValid;
+
+/*!
+ *  Number of bytes a block access of the external SRAM transfers at most with
+ *  preemption disabled. Preemption is allowed between two pieces, and the
+ *  next piece simply continues the open transfer unless another process
+ *  accessed the SRAM in between.
+ */
+#define EXT_SRAM_PIECE 32
+
+/*!
+ *  Ends the open transfer, so the next access sends its instruction and
+ *  address again.
+ */
+void closeStream_external(void) {
+	if (extStream != EXT_STREAM_CLOSED) {
+		deselect_memory();
+		extStream = EXT_STREAM_CLOSED;
+	}
+}
+
+/*!
+ *  Makes sure the external SRAM transfers data in the given direction
+ *  starting at addr. In sequential mode the chip keeps incrementing its
+ *  address as long as it stays selected, so an access to the address after
+ *  the previous one in the same direction continues the open transfer
+ *  instead of sending the instruction and address again.
+ *  Must be called with preemption disabled.
+ *
+ *  \param stream The direction of the transfer.
+ *  \param addr The address of the next byte.
+ *  \param length The number of bytes that will be transferred.
+ */
+void openStream_external(ExtStream stream, MemAddr addr, uint16_t length) {
+	if (extStream != stream || extStreamNext != addr) {
+		closeStream_external();
+		select_memory();
+		os_spi_send(stream == EXT_STREAM_READ ? SPI_INS_READ : SPI_INS_WRITE);
+		transfer_adress(addr);
+		extStream = stream;
+	}
+	extStreamNext = addr + length;
+}
+
+/*!
+ *  Ends the open transfer if it reached the end of the address space, since
+ *  the chip would continue beyond 0xFFFF instead of at 0.
+ */
+void checkStreamEnd_external(void) {
+	if (extStreamNext == 0) {
+		closeStream_external();
+	}
+}
+
 void initSRAM_external(void) {
 	// Configure CS
 	sbi(DDRB, SPI_CS);
 	deselect_memory();
+	extStream = EXT_STREAM_CLOSED;
+	extCacheValid = false;
 	os_spi_init();
-	// Set Operation Mode to Byte Operation
-	set_operation_mode(0);
+	// Set Operation Mode to Sequential Operation, which allows to keep
+	// transfers open for consecutive addresses
+	set_operation_mode(SPI_MODE_SEQUENTIAL);
 }
 
 MemValue readSRAM_external(MemAddr addr) {
-	os_enterCriticalSection();
-	select_memory();
-	os_spi_send(SPI_INS_READ);
-	transfer_adress(addr);
-	uint8_t result = os_spi_receive();
-	deselect_memory();
-	os_leaveCriticalSection();
+	os_disablePreemption();
+	if (!extCacheValid || extCacheAddr != addr) {
+		openStream_external(EXT_STREAM_READ, addr, 1);
+		extCacheValue = os_spi_receive();
+		checkStreamEnd_external();
+		extCacheAddr = addr;
+		extCacheValid = true;
+	}
+	uint8_t result = extCacheValue;
+	os_enablePreemption();
 	return result;
 }
 
 void writeSRAM_external(MemAddr addr, MemValue value) {
-	os_enterCriticalSection();
-	select_memory();
-	os_spi_send(SPI_INS_WRITE);
-	transfer_adress(addr);
+	os_disablePreemption();
+	if (extCacheAddr == addr) {
+		extCacheValue = value;
+	}
+	openStream_external(EXT_STREAM_WRITE, addr, 1);
 	os_spi_send(value);
-	deselect_memory();
-	os_leaveCriticalSection();
+	checkStreamEnd_external();
+	os_enablePreemption();
+}
+
+void readBlockSRAM_external(MemAddr addr, MemValue* buffer, uint16_t length) {
+	while (length != 0) {
+		uint8_t const piece = length < EXT_SRAM_PIECE ? length : EXT_SRAM_PIECE;
+		os_disablePreemption();
+		openStream_external(EXT_STREAM_READ, addr, piece);
+		for (uint8_t i = 0; i < piece; i++) {
+			*buffer++ = os_spi_receive();
+		}
+		checkStreamEnd_external();
+		os_enablePreemption();
+		addr += piece;
+		length -= piece;
+	}
+}
+
+void writeBlockSRAM_external(MemAddr addr, MemValue const* buffer, uint16_t length) {
+	while (length != 0) {
+		uint8_t const piece = length < EXT_SRAM_PIECE ? length : EXT_SRAM_PIECE;
+		os_disablePreemption();
+		if ((MemAddr)(extCacheAddr - addr) < piece) {
+			extCacheValid = false;
+		}
+		openStream_external(EXT_STREAM_WRITE, addr, piece);
+		for (uint8_t i = 0; i < piece; i++) {
+			os_spi_send(*buffer++);
+		}
+		checkStreamEnd_external();
+		os_enablePreemption();
+		addr += piece;
+		length -= piece;
+	}
+}
+
+void fillSRAM_external(MemAddr addr, MemValue value, uint16_t length) {
+	while (length != 0) {
+		uint8_t const piece = length < EXT_SRAM_PIECE ? length : EXT_SRAM_PIECE;
+		os_disablePreemption();
+		if ((MemAddr)(extCacheAddr - addr) < piece) {
+			extCacheValid = false;
+		}
+		openStream_external(EXT_STREAM_WRITE, addr, piece);
+		for (uint8_t i = 0; i < piece; i++) {
+			os_spi_send(value);
+		}
+		checkStreamEnd_external();
+		os_enablePreemption();
+		addr += piece;
+		length -= piece;
+	}
 }
 
 MemDriver extSRAM__ = {
 	.init = &initSRAM_external,
 	.read = &readSRAM_external,
 	.write = &writeSRAM_external,
+	.readBlock = &readBlockSRAM_external,
+	.writeBlock = &writeBlockSRAM_external,
+	.fill = &fillSRAM_external,
 	.start = EXT_SRAM_START,
 	.size = EXT_MEMORY_SRAM
 };
@@ -13,6 +13,9 @@ typedef struct MemDriver {
 	void (*init)(void);
 	MemValue (*read)(MemAddr addr);
 	void (*write)(MemAddr addr, MemValue value);
+	void (*readBlock)(MemAddr addr, MemValue* buffer, uint16_t length);
+	void (*writeBlock)(MemAddr addr, MemValue const* buffer, uint16_t length);
+	void (*fill)(MemAddr addr, MemValue value, uint16_t length);
 } MemDriver;
 
 extern MemDriver intSRAM__;
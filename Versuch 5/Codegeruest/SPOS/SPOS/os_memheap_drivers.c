@@ -1,44 +1,62 @@
 #include "os_memheap_drivers.h"
+#include "os_memory.h"
 #include "os_spi.h"
 
 char PROGMEM const intStr[] = "internal";
 char PROGMEM const extStr[] = "external";
 
+//! Blocks of the map of the internal heap that are known to be entirely free
+uint8_t intHeapSummaryFree[HEAP_SUMMARY_SIZE(HEAP_MAP_SIZE(INT_HEAP_SIZE_MAX))];
+
+//! Blocks of the map of the internal heap that are known to be entirely continuation
+uint8_t intHeapSummaryCont[HEAP_SUMMARY_SIZE(HEAP_MAP_SIZE(INT_HEAP_SIZE_MAX))];
+
+//! Blocks of the map of the external heap that are known to be entirely free
+uint8_t extHeapSummaryFree[HEAP_SUMMARY_SIZE(HEAP_MAP_SIZE(EXT_MEMORY_SRAM))];
+
+//! Blocks of the map of the external heap that are known to be entirely continuation
+uint8_t extHeapSummaryCont[HEAP_SUMMARY_SIZE(HEAP_MAP_SIZE(EXT_MEMORY_SRAM))];
+
 Heap intHeap__ = {
 	.driver = intSRAM,
-	.map_start = AVR_SRAM_START + HEAP_OFFSET,
-	.map_size = (AVR_MEMORY_SRAM / 2 - HEAP_OFFSET) / 3,
-	.use_start = AVR_SRAM_START + HEAP_OFFSET + (AVR_MEMORY_SRAM / 2 - HEAP_OFFSET) / 3,
-	.use_size = ((AVR_MEMORY_SRAM / 2 - HEAP_OFFSET) / 3) * 2,
 	.alloc_strategy = OS_MEM_FIRST,
 	.name = intStr,
-	.last_addr = AVR_SRAM_START + HEAP_OFFSET + (AVR_MEMORY_SRAM / 2 - HEAP_OFFSET) / 3,
 	.first_used = {0},
-	.last_used = {0}
+	.last_used = {0},
+	.summary_free = intHeapSummaryFree,
+	.summary_cont = intHeapSummaryCont
 };
 
 Heap extHeap__ = {
 	.driver = extSRAM,
-	.map_start = EXT_SRAM_START,
-	.map_size = EXT_MEMORY_SRAM / 3,
-	.use_start = EXT_SRAM_START + EXT_MEMORY_SRAM / 3,
-	.use_size = (EXT_MEMORY_SRAM / 3) * 2,
 	.alloc_strategy = OS_MEM_FIRST,
 	.name = extStr,
-	.last_addr = EXT_SRAM_START + EXT_MEMORY_SRAM / 3,
 	.first_used = {0},
-	.last_used = {0}
+	.last_used = {0},
+	.summary_free = extHeapSummaryFree,
+	.summary_cont = extHeapSummaryCont
 };
 
-void os_initHeap(Heap heap) {
-	for (MemAddr i = heap.map_start; i < heap.use_start; i++) {
-		heap.driver->write(i, 0);
-	}
+/*!
+ *  Lays out a heap in the memory of its driver, which has to be initialized
+ *  already, and clears its map. The map takes the first part of the memory
+ *  and the usable part follows it.
+ *
+ *  \param heap The heap to initialize.
+ */
+void os_initHeap(Heap* heap) {
+	heap->map_start = heap->driver->start;
+	heap->map_size = HEAP_MAP_SIZE(heap->driver->size);
+	heap->use_start = heap->map_start + heap->map_size;
+	heap->use_size = heap->map_size * HEAP_USE_PER_MAP_BYTE;
+	heap->last_addr = heap->use_start;
+	heap->driver->fill(heap->map_start, 0, heap->map_size);
+	os_resetHeapIndex(heap);
 }
 
 void os_initHeaps(void) {
-	os_initHeap(intHeap__);
-	os_initHeap(extHeap__);
+	os_initHeap(intHeap);
+	os_initHeap(extHeap);
 }
 
 uint8_t os_getHeapListLength() {
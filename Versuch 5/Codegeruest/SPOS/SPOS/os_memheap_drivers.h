@@ -16,6 +16,70 @@ typedef enum AllocStrategy {
 	OS_MEM_WORST
 } AllocStrategy;
 
+/*!
+ *  Width of a map entry. Every byte of the use section has an entry that holds
+ *  0 (free), HEAP_MAP_CONTINUATION, the ID of the owning process or the lock
+ *  state of a shared chunk (HEAP_MAP_SH_CLOSED and above). The upper half of
+ *  a nibble is taken by the shared states, so with more than 8 processes the
+ *  IDs no longer fit into a nibble.
+ */
+#if MAX_NUMBER_OF_PROCESSES > 8
+#define HEAP_MAP_ENTRY_BITS 8
+#else
+#define HEAP_MAP_ENTRY_BITS 4
+#endif
+
+//! Map entry of a byte that continues the chunk of its predecessor
+#define HEAP_MAP_CONTINUATION ((1 << HEAP_MAP_ENTRY_BITS) - 1)
+
+//! Maximum number of processes that may have a shared chunk opened for reading at once
+#define HEAP_MAP_SH_MAX_READERS 5
+
+//! Maximum number of different shared chunks a process may have opened at once
+#define HEAP_SH_OPENS_PER_PROCESS 2
+
+//! Map entry of the first byte of a shared chunk that is opened for writing
+#define HEAP_MAP_SH_WRITE (HEAP_MAP_CONTINUATION - 1)
+
+//! Map entry of the first byte of a shared chunk that is not opened
+#define HEAP_MAP_SH_CLOSED (HEAP_MAP_SH_WRITE - 1 - HEAP_MAP_SH_MAX_READERS)
+
+//! Map entry of the first byte of a shared chunk that is opened by N readers
+#define HEAP_MAP_SH_READ(N) (HEAP_MAP_SH_CLOSED + (N))
+
+//! Whether a map entry is the first byte of a shared chunk
+#define HEAP_MAP_IS_SHARED(ENTRY) ((ENTRY) >= HEAP_MAP_SH_CLOSED && (ENTRY) <= HEAP_MAP_SH_WRITE)
+
+//! Number of bytes of the use section that are described by one map byte
+#define HEAP_USE_PER_MAP_BYTE (8 / HEAP_MAP_ENTRY_BITS)
+
+//! Size of the map of a heap that occupies SIZE bytes in total
+#define HEAP_MAP_SIZE(SIZE) ((SIZE) / (1 + HEAP_USE_PER_MAP_BYTE))
+
+//! Number of map bytes that are summarized by one bit of the summary bitmaps of a heap
+#define HEAP_SUMMARY_GRANULARITY 128
+
+//! Size of each summary bitmap of a heap with a map of MAP_SIZE bytes
+#define HEAP_SUMMARY_SIZE(MAP_SIZE) ((((MAP_SIZE) + HEAP_SUMMARY_GRANULARITY - 1) / HEAP_SUMMARY_GRANULARITY + 7) / 8)
+
+//! Number of bytes that are copied at once when a chunk is moved within a heap
+#define HEAP_COPY_BUFFER_SIZE 16
+
+/*!
+ *  Maximum number of free blocks a heap keeps track of. A heap can have up to
+ *  half as many free blocks as its use section has bytes, far more than fit
+ *  into the internal SRAM, so the index does not cover the worst case. While
+ *  there are more free blocks, allocations scan the map (skipping summarized
+ *  blocks) and the index is built again once free_holes drops to this limit.
+ */
+#define HEAP_FREE_BLOCKS 8
+
+//! A range of free bytes in the use section of a heap
+typedef struct FreeBlock {
+	MemAddr start;
+	uint16_t length;
+} FreeBlock;
+
 typedef struct Heap {
 	MemDriver *driver;
 	MemAddr map_start;
@@ -27,6 +91,12 @@ typedef struct Heap {
 	MemAddr last_addr;
 	MemAddr first_used[MAX_NUMBER_OF_PROCESSES];
 	MemAddr last_used[MAX_NUMBER_OF_PROCESSES];
+	FreeBlock free_blocks[HEAP_FREE_BLOCKS];
+	uint8_t free_count;
+	bool free_valid;
+	uint16_t free_holes;
+	uint8_t* summary_free;
+	uint8_t* summary_cont;
 } Heap;
 
 extern Heap intHeap__;
@@ -2,6 +2,88 @@
 #include "os_memory_strategies.h"
 #include "os_core.h"
 
+//! Processes that are blocked until a shared chunk is closed or freed
+ProcessMask os_shWaiters;
+
+//! Number of bytes of the use section that are summarized by one bit of the summary bitmaps
+#define HEAP_SUMMARY_USE_BYTES ((uint16_t)HEAP_SUMMARY_GRANULARITY * HEAP_USE_PER_MAP_BYTE)
+
+//----------------------------------------------------------------------------
+// Summary bitmaps
+//----------------------------------------------------------------------------
+
+/*
+ *  Every heap has two bitmaps in internal SRAM with one bit per
+ *  HEAP_SUMMARY_GRANULARITY map bytes. A set bit means that the block is
+ *  known to consist of free entries (summary_free) or continuation entries
+ *  (summary_cont) only, so scans may jump over it. Bits are cleared by every
+ *  write to the map that breaks the block and set again when a whole block
+ *  is freed or allocated at once.
+ */
+
+static bool os_summaryTest(uint8_t const* bitmap, uint16_t block) {
+	return bitmap[block / 8] & (1 << (block % 8));
+}
+
+static void os_summarySet(uint8_t* bitmap, uint16_t block) {
+	bitmap[block / 8] |= 1 << (block % 8);
+}
+
+static void os_summaryClear(uint8_t* bitmap, uint16_t block) {
+	bitmap[block / 8] &= ~(1 << (block % 8));
+}
+
+//! Clears the bits of the block of addr that no longer hold after value was written to its map entry
+static void os_summaryUpdate(Heap const* heap, MemAddr addr, MemValue value) {
+	uint16_t block = (addr - heap->use_start) / HEAP_SUMMARY_USE_BYTES;
+	if (value != 0) {
+		os_summaryClear(heap->summary_free, block);
+	}
+	if (value != HEAP_MAP_CONTINUATION) {
+		os_summaryClear(heap->summary_cont, block);
+	}
+}
+
+//! Sets the bits of all blocks that lie entirely within [from, to)
+static void os_summaryMarkRange(Heap const* heap, uint8_t* bitmap, MemAddr from, MemAddr to) {
+	uint16_t end = to - heap->use_start;
+	uint16_t block = (from - heap->use_start + HEAP_SUMMARY_USE_BYTES - 1) / HEAP_SUMMARY_USE_BYTES;
+	for (; block * HEAP_SUMMARY_USE_BYTES < end; block++) {
+		uint16_t blockEnd = (block + 1) * HEAP_SUMMARY_USE_BYTES;
+		if (blockEnd > heap->use_size) {
+			blockEnd = heap->use_size;
+		}
+		if (blockEnd <= end) {
+			os_summarySet(bitmap, block);
+		}
+	}
+}
+
+//! Advances addr over all following blocks whose bit is set
+static MemAddr os_summarySkipForward(Heap const* heap, uint8_t const* bitmap, MemAddr addr) {
+	uint16_t offset = addr - heap->use_start;
+	while (offset < heap->use_size && os_summaryTest(bitmap, offset / HEAP_SUMMARY_USE_BYTES)) {
+		offset = (offset / HEAP_SUMMARY_USE_BYTES + 1) * HEAP_SUMMARY_USE_BYTES;
+	}
+	if (offset > heap->use_size) {
+		offset = heap->use_size;
+	}
+	return heap->use_start + offset;
+}
+
+//! Moves addr back to the first byte of the run of blocks with set bits it lies in
+static MemAddr os_summarySkipBackward(Heap const* heap, uint8_t const* bitmap, MemAddr addr) {
+	uint16_t offset = addr - heap->use_start;
+	while (os_summaryTest(bitmap, offset / HEAP_SUMMARY_USE_BYTES)) {
+		uint16_t blockStart = offset / HEAP_SUMMARY_USE_BYTES * HEAP_SUMMARY_USE_BYTES;
+		if (blockStart == 0) {
+			return heap->use_start;
+		}
+		offset = blockStart - 1;
+	}
+	return heap->use_start + offset;
+}
+
 void setLowNibble(Heap const *heap, MemAddr addr, MemValue value) {
 	heap->driver->write(addr, (value & 0xF) | (heap->driver->read(addr) & 0xF0));
 }
@@ -22,16 +104,30 @@ MemAddr getMapAddress(Heap const *heap, MemAddr addr) {
 	if (addr >= heap->use_start + heap->use_size || addr < heap->use_start) {
 		os_error("Heap: Out of bounds!");
 	}
-	return (addr - heap->use_start) / 2 + heap->map_start;
+	return (addr - heap->use_start) / HEAP_USE_PER_MAP_BYTE + heap->map_start;
+}
+
+#if HEAP_MAP_ENTRY_BITS == 8
+
+void setMapEntry(Heap const* heap, MemAddr addr, MemValue value) {
+	heap->driver->write(getMapAddress(heap, addr), value);
+	os_summaryUpdate(heap, addr, value);
+}
+
+MemValue os_getMapEntry(Heap const* heap, MemAddr addr) {
+	return heap->driver->read(getMapAddress(heap, addr));
 }
 
-void setMapEntry(Heap* heap, MemAddr addr, MemValue value) {
+#else
+
+void setMapEntry(Heap const* heap, MemAddr addr, MemValue value) {
 	MemAddr map_addr = getMapAddress(heap, addr);
 	if ((addr - heap->use_start) % 2 == 0) {
 		setHighNibble(heap, map_addr, value);
 	} else {
 		setLowNibble(heap, map_addr, value);
 	}
+	os_summaryUpdate(heap, addr, value);
 }
 
 MemValue os_getMapEntry(Heap const* heap, MemAddr addr) {
@@ -43,9 +139,15 @@ MemValue os_getMapEntry(Heap const* heap, MemAddr addr) {
 	}
 }
 
+#endif
+
 MemAddr os_getFirstByteOfChunk(Heap const* heap, MemAddr addr) {
 	if(addr >= heap->use_start + heap->use_size || addr < heap->use_start) return 0;
-	while (addr >= heap->use_start && os_getMapEntry(heap, addr) == 0xF) addr--;
+	while (addr >= heap->use_start) {
+		addr = os_summarySkipBackward(heap, heap->summary_cont, addr);
+		if (os_getMapEntry(heap, addr) != HEAP_MAP_CONTINUATION) break;
+		addr--;
+	}
 	return addr;
 }
 
@@ -56,31 +158,232 @@ ProcessID getOwnerOfChunk(Heap const* heap, MemAddr addr) {
 uint16_t os_getChunkSize(Heap const* heap, MemAddr addr) {
 	MemAddr start = os_getFirstByteOfChunk(heap, addr);
 	if (os_getMapEntry(heap, start) == 0) return 0;
-	uint16_t l = 1;
-	while (start + l < heap->use_start + heap->use_size && os_getMapEntry(heap, start + l) == 0xF) {
-		l++;
+	MemAddr end = start + 1;
+	while (end < heap->use_start + heap->use_size) {
+		end = os_summarySkipForward(heap, heap->summary_cont, end);
+		if (end >= heap->use_start + heap->use_size || os_getMapEntry(heap, end) != HEAP_MAP_CONTINUATION) break;
+		end++;
+	}
+	return end - start;
+}
+
+//----------------------------------------------------------------------------
+// Free block index
+//----------------------------------------------------------------------------
+
+/*!
+ *  Finds the next free block by scanning the map.
+ *
+ *  \param heap The heap to search.
+ *  \param from The first address to consider.
+ *  \param block Receives the free block.
+ *  \return False if there is no free byte at or after from.
+ */
+static bool os_scanFreeBlock(Heap const* heap, MemAddr from, FreeBlock* block) {
+	MemAddr end = heap->use_start + heap->use_size;
+	MemAddr addr = from;
+	while (addr < end) {
+		addr = os_summarySkipForward(heap, heap->summary_cont, addr);
+		if (addr >= end || os_getMapEntry(heap, addr) == 0) break;
+		addr++;
+	}
+	if (addr >= end) {
+		return false;
+	}
+	block->start = addr;
+	while (addr < end) {
+		addr = os_summarySkipForward(heap, heap->summary_free, addr);
+		if (addr >= end || os_getMapEntry(heap, addr) != 0) break;
+		addr++;
+	}
+	block->length = addr - block->start;
+	return true;
+}
+
+//! Whether addr lies within the use section of a heap and is free
+static bool os_isFreeByte(Heap const* heap, MemAddr addr) {
+	return addr >= heap->use_start && addr < heap->use_start + heap->use_size && os_getMapEntry(heap, addr) == 0;
+}
+
+/*!
+ *  Inserts a block into the index at position i. If the index is full, it is
+ *  given up until free_holes shows that the map has fewer free blocks again.
+ */
+static void os_freeIndexInsert(Heap* heap, uint8_t i, MemAddr start, uint16_t length) {
+	if (heap->free_count == HEAP_FREE_BLOCKS) {
+		heap->free_valid = false;
+		return;
+	}
+	for (uint8_t j = heap->free_count; j > i; j--) {
+		heap->free_blocks[j] = heap->free_blocks[j - 1];
 	}
-	return l;
+	heap->free_blocks[i].start = start;
+	heap->free_blocks[i].length = length;
+	heap->free_count++;
+}
+
+//! Removes the block at position i from the index
+static void os_freeIndexRemove(Heap* heap, uint8_t i) {
+	heap->free_count--;
+	for (; i < heap->free_count; i++) {
+		heap->free_blocks[i] = heap->free_blocks[i + 1];
+	}
+}
+
+/*!
+ *  Removes a range that has just been allocated from the index. The range
+ *  has to lie within one free block. The number of free blocks is kept up to
+ *  date even without an index, from the two bytes around the range.
+ */
+static void os_freeIndexTake(Heap* heap, MemAddr start, uint16_t length) {
+	// The block is split in two, shortened or used up
+	heap->free_holes += os_isFreeByte(heap, start - 1) + os_isFreeByte(heap, start + length) - 1;
+	if (!heap->free_valid) {
+		return;
+	}
+	for (uint8_t i = 0; i < heap->free_count; i++) {
+		FreeBlock* block = &heap->free_blocks[i];
+		if (start >= block->start && start - block->start < block->length) {
+			uint16_t tail = block->length - (start - block->start) - length;
+			if (start != block->start) {
+				block->length = start - block->start;
+				if (tail != 0) {
+					os_freeIndexInsert(heap, i + 1, start + length, tail);
+				}
+			} else if (tail != 0) {
+				block->start = start + length;
+				block->length = tail;
+			} else {
+				os_freeIndexRemove(heap, i);
+			}
+			return;
+		}
+	}
+	// The index does not match the map, so it has to be built again
+	heap->free_valid = false;
+}
+
+/*!
+ *  Adds a range that has just been freed to the index and merges it with
+ *  adjacent free blocks. The bytes around the range must not have changed
+ *  since it was freed.
+ */
+static void os_freeIndexGive(Heap* heap, MemAddr start, uint16_t length) {
+	// The range becomes a block of its own, extends one or joins two
+	heap->free_holes += 1 - os_isFreeByte(heap, start - 1) - os_isFreeByte(heap, start + length);
+	if (!heap->free_valid) {
+		return;
+	}
+	uint8_t i = 0;
+	while (i < heap->free_count && heap->free_blocks[i].start < start) {
+		i++;
+	}
+	bool mergeNext = i < heap->free_count && start + length == heap->free_blocks[i].start;
+	if (i > 0 && heap->free_blocks[i - 1].start + heap->free_blocks[i - 1].length == start) {
+		heap->free_blocks[i - 1].length += length;
+		if (mergeNext) {
+			heap->free_blocks[i - 1].length += heap->free_blocks[i].length;
+			os_freeIndexRemove(heap, i);
+		}
+	} else if (mergeNext) {
+		heap->free_blocks[i].start = start;
+		heap->free_blocks[i].length += length;
+	} else {
+		os_freeIndexInsert(heap, i, start, length);
+	}
+}
+
+//! Builds the index from the map, which must not have more than HEAP_FREE_BLOCKS free blocks
+static void os_freeIndexRebuild(Heap* heap) {
+	FreeBlock block;
+	heap->free_count = 0;
+	heap->free_valid = true;
+	for (MemAddr from = heap->use_start; heap->free_valid && os_scanFreeBlock(heap, from, &block); from = block.start + block.length) {
+		os_freeIndexInsert(heap, heap->free_count, block.start, block.length);
+	}
+}
+
+/*!
+ *  Marks the whole use section of a heap as free in the index and the
+ *  summary bitmaps. Has to be called whenever the map has been cleared.
+ *
+ *  \param heap The heap whose map was cleared.
+ */
+void os_resetHeapIndex(Heap* heap) {
+	heap->free_blocks[0].start = heap->use_start;
+	heap->free_blocks[0].length = heap->use_size;
+	heap->free_count = 1;
+	heap->free_valid = true;
+	heap->free_holes = 1;
+	for (uint16_t i = 0; i < HEAP_SUMMARY_SIZE(heap->map_size); i++) {
+		heap->summary_free[i] = 0xFF;
+		heap->summary_cont[i] = 0;
+	}
+}
+
+/*!
+ *  Finds the first free block that ends after from. The index is used if it
+ *  describes all free blocks, otherwise the map is scanned.
+ *
+ *  \param heap The heap to search.
+ *  \param from The first address to consider. A free block containing it is cut to start at from.
+ *  \param block Receives the free block.
+ *  \return False if there is no free byte at or after from.
+ */
+bool os_getNextFreeBlock(Heap const* heap, MemAddr from, FreeBlock* block) {
+	if (!heap->free_valid) {
+		return os_scanFreeBlock(heap, from, block);
+	}
+	for (uint8_t i = 0; i < heap->free_count; i++) {
+		FreeBlock const* candidate = &heap->free_blocks[i];
+		if (from < candidate->start) {
+			*block = *candidate;
+			return true;
+		}
+		if (from - candidate->start < candidate->length) {
+			block->start = from;
+			block->length = candidate->length - (from - candidate->start);
+			return true;
+		}
+	}
+	return false;
 }
 
 void os_freeOwnerRestricted(Heap* heap, MemAddr addr, ProcessID owner) {
-	os_enterCriticalSection();
+	os_disablePreemption();
 	MemAddr start = os_getFirstByteOfChunk(heap, addr);
 	if (start >= heap->use_start + heap->use_size || start < heap->use_start) {
-		os_leaveCriticalSection();
+		os_enablePreemption();
 		return;
 	}
 	if ((ProcessID) os_getMapEntry(heap, start) == owner) {
+		MemAddr first = start;
 		do {
 			setMapEntry(heap, start, 0);
 			start++;
-		} while (start < heap->use_start + heap->use_size && os_getMapEntry(heap, start) == 0xF);
+		} while (start < heap->use_start + heap->use_size && os_getMapEntry(heap, start) == HEAP_MAP_CONTINUATION);
+		os_freeIndexGive(heap, first, start - first);
+		os_summaryMarkRange(heap, heap->summary_free, first, start);
 	}
-	os_leaveCriticalSection();
+	os_enablePreemption();
 }
 
-MemAddr os_malloc(Heap* heap, uint16_t size) {
-	os_enterCriticalSection();
+/*!
+ *  Allocates a chunk and marks it with the given map entry instead of the
+ *  ID of the current process.
+ *
+ *  \param heap The heap to allocate on.
+ *  \param size The size of the chunk.
+ *  \param owner The owning process or HEAP_MAP_SH_CLOSED for shared memory.
+ *  \return The first byte of the chunk or 0 if there is no room.
+ */
+MemAddr os_mallocOwner(Heap* heap, uint16_t size, MemValue owner) {
+	os_disablePreemption();
+	// Without the index every allocation scans the map, so it is built again
+	// as soon as all free blocks fit into it
+	if (!heap->free_valid && heap->free_holes <= HEAP_FREE_BLOCKS) {
+		os_freeIndexRebuild(heap);
+	}
 	MemAddr address = 0;
 	switch(os_getAllocationStrategy(heap)) {
 		case OS_MEM_BEST: address = os_Memory_BestFit(heap, size); break;
@@ -92,29 +395,71 @@ MemAddr os_malloc(Heap* heap, uint16_t size) {
 		if(address >= heap->use_start + heap->use_size || address + size < heap->use_start) {
 			os_error("Alloc Strat wrong");
 		}
-		ProcessID cp = os_getCurrentProc();
-		setMapEntry(heap, address, cp);
+		setMapEntry(heap, address, owner);
 		for (uint16_t i = 1; i < size; i++) {
-			setMapEntry(heap, address + i, 0xF);
+			setMapEntry(heap, address + i, HEAP_MAP_CONTINUATION);
 		}
+		os_freeIndexTake(heap, address, size);
+		os_summaryMarkRange(heap, heap->summary_cont, address + 1, address + size);
 		
-		if (heap->first_used[cp] == 0 || address < heap->first_used[cp]) {
-			heap->first_used[cp] = address;
-		}
-		if (heap->last_used[cp] == 0 || address > heap->last_used[cp]) {
-			heap->last_used[cp] = address ;
+		if (owner < MAX_NUMBER_OF_PROCESSES) {
+			if (heap->first_used[owner] == 0 || address < heap->first_used[owner]) {
+				heap->first_used[owner] = address;
+			}
+			if (heap->last_used[owner] == 0 || address > heap->last_used[owner]) {
+				heap->last_used[owner] = address ;
+			}
 		}
 
 	}
 	
-	os_leaveCriticalSection();
+	os_enablePreemption();
 	return address;
 }
 
+MemAddr os_malloc(Heap* heap, uint16_t size) {
+	return os_mallocOwner(heap, size, os_getCurrentProc());
+}
+
 void os_free(Heap* heap, MemAddr address) {
+	MemAddr start = os_getFirstByteOfChunk(heap, address);
+	if (start != 0 && HEAP_MAP_IS_SHARED(os_getMapEntry(heap, start))) {
+		os_error("os_free on shared memory");
+		return;
+	}
 	os_freeOwnerRestricted(heap, address, os_getCurrentProc());
 }
 
+/*!
+ *  Hands a chunk over to another process without copying it. The chunk is
+ *  then freed with the memory of its new owner.
+ *
+ *  \param heap The heap the chunk resides in.
+ *  \param addr The first byte of the chunk.
+ *  \param from The process that owns the chunk.
+ *  \param to The new owner.
+ *  \return True if the chunk was owned by from and has been handed over.
+ */
+bool os_transferChunk(Heap* heap, MemAddr addr, ProcessID from, ProcessID to) {
+	if (addr >= heap->use_start + heap->use_size || addr < heap->use_start) {
+		return false;
+	}
+	os_disablePreemption();
+	if ((ProcessID) os_getMapEntry(heap, addr) != from) {
+		os_enablePreemption();
+		return false;
+	}
+	setMapEntry(heap, addr, to);
+	if (heap->first_used[to] == 0 || addr < heap->first_used[to]) {
+		heap->first_used[to] = addr;
+	}
+	if (heap->last_used[to] == 0 || addr > heap->last_used[to]) {
+		heap->last_used[to] = addr;
+	}
+	os_enablePreemption();
+	return true;
+}
+
 size_t os_getMapSize(Heap const* heap) {
 	return heap->map_size;
 }
@@ -139,71 +484,87 @@ void os_setAllocationStrategy(Heap* heap, AllocStrategy allocStrat) {
 	heap->alloc_strategy = allocStrat;
 }
 
+/*!
+ *  Frees all chunks of a process. The map is walked chunk by chunk between
+ *  first_used and last_used, jumping over summarized free and continuation
+ *  blocks, and every chunk of the process is freed as a whole.
+ *
+ *  \param heap The heap to free the memory on.
+ *  \param pid The process whose chunks are freed.
+ */
 void os_freeProcessMemory(Heap* heap, ProcessID pid) {
-	os_enterCriticalSection();
-	MemAddr start = heap->first_used[pid];
+	os_disablePreemption();
+	MemAddr addr = heap->first_used[pid];
 	MemAddr end = heap->last_used[pid];
-	if (start == 0) {
-		start = heap->use_start;
+	if (addr == 0) {
+		addr = heap->use_start;
 	}
 	if (end == 0) {
 		end = heap->use_start + heap->use_size - 1;
 	}
-	for (size_t i = start; i <= end; i++) {
-		os_freeOwnerRestricted(heap, i, pid);
+	while (addr <= end) {
+		addr = os_summarySkipForward(heap, heap->summary_free, addr);
+		addr = os_summarySkipForward(heap, heap->summary_cont, addr);
+		if (addr > end) {
+			break;
+		}
+		MemValue value = os_getMapEntry(heap, addr);
+		if (value == 0 || value == HEAP_MAP_CONTINUATION) {
+			addr++;
+		} else if ((ProcessID) value == pid) {
+			MemAddr first = addr;
+			do {
+				setMapEntry(heap, addr, 0);
+				addr++;
+			} while (addr < heap->use_start + heap->use_size && os_getMapEntry(heap, addr) == HEAP_MAP_CONTINUATION);
+			os_freeIndexGive(heap, first, addr - first);
+			os_summaryMarkRange(heap, heap->summary_free, first, addr);
+		} else {
+			addr++;
+		}
+	}
+	os_enablePreemption();
+}
+
+/*!
+ *  Copies bytes within a heap in pieces of HEAP_COPY_BUFFER_SIZE bytes. The
+ *  ranges may overlap.
+ *
+ *  \param heap The heap to copy within.
+ *  \param to The first byte of the destination.
+ *  \param from The first byte of the source.
+ *  \param length The number of bytes to copy.
+ */
+static void os_copyWithin(Heap const* heap, MemAddr to, MemAddr from, uint16_t length) {
+	MemValue buffer[HEAP_COPY_BUFFER_SIZE];
+	uint16_t done = 0;
+	while (done < length) {
+		uint16_t n = (length - done < HEAP_COPY_BUFFER_SIZE) ? length - done : HEAP_COPY_BUFFER_SIZE;
+		// Moving up copies from the end, so no byte is overwritten before it was read
+		uint16_t offset = (to < from) ? done : length - done - n;
+		heap->driver->readBlock(from + offset, buffer, n);
+		heap->driver->writeBlock(to + offset, buffer, n);
+		done += n;
 	}
-	os_leaveCriticalSection();
 }
 
 void moveChunk(Heap* heap, MemAddr oldChunk, size_t oldSize, MemAddr newChunk, size_t newSize) {
-	if(oldChunk > newChunk) { // Move backwards
-		MemAddr start = newChunk;
-		
-		setMapEntry(heap, newChunk, os_getCurrentProc());
-		heap->driver->write(newChunk, heap->driver->read(oldChunk));
-		setMapEntry(heap, oldChunk, 0);
-		oldChunk++;
-		newChunk++;
-		
-		while(oldChunk < heap->use_start + heap->use_size && os_getMapEntry(heap, oldChunk) == 0xF) {
-			setMapEntry(heap, newChunk, 0xF);
-			heap->driver->write(newChunk, heap->driver->read(oldChunk));
-			setMapEntry(heap, oldChunk, 0);
-			oldChunk++;
-			newChunk++;
-		}
-	
-		for (; newChunk < start + newSize; newChunk++) {
-			// if we do not init values with 0 can't a process get all the heap and read it out?
-			setMapEntry(heap, newChunk, 0xF);
-		}
-		
-	}else if(oldChunk < newChunk) { // Move forwards
-		MemAddr end_old = oldChunk + oldSize - 1;
-		MemAddr end_new = newChunk + newSize;
-		for (uint16_t i = 0; i < newChunk - oldChunk; i++) {
-			setMapEntry(heap, end_new, 0xF);
-			end_new--;
-		}
-		
-		while (os_getMapEntry(heap, end_old) == 0) {
-			setMapEntry(heap, end_new, 0xF);
-			heap->driver->write(end_new, heap->driver->read(end_old));
-			setMapEntry(heap, end_old, 0);
-			end_old++;
-			end_new++;
+	os_copyWithin(heap, newChunk, oldChunk, oldSize);
+	for (MemAddr i = oldChunk; i < oldChunk + oldSize; i++) {
+		if (i < newChunk || i >= newChunk + newSize) {
+			setMapEntry(heap, i, 0);
 		}
-		
-		setMapEntry(heap, end_new, os_getCurrentProc());
-		heap->driver->write(end_new, heap->driver->read(end_old));
-		setMapEntry(heap, end_old, 0);
+	}
+	setMapEntry(heap, newChunk, os_getCurrentProc());
+	for (MemAddr i = newChunk + 1; i < newChunk + newSize; i++) {
+		setMapEntry(heap, i, HEAP_MAP_CONTINUATION);
 	}
 }
 
 MemAddr os_realloc(Heap* heap, MemAddr addr, uint16_t size) {
-	os_enterCriticalSection();
+	os_disablePreemption();
 	if ((ProcessID) os_getMapEntry(heap, addr) != os_getCurrentProc()) {
-		os_leaveCriticalSection();
+		os_enablePreemption();
 		return 0;
 	}
 	
@@ -213,6 +574,11 @@ MemAddr os_realloc(Heap* heap, MemAddr addr, uint16_t size) {
 		for(MemAddr i = addr + size; i < addr + oldSize; i++) {
 			setMapEntry(heap, i, 0);
 		}
+		if (size < oldSize) {
+			os_freeIndexGive(heap, addr + size, oldSize - size);
+			os_summaryMarkRange(heap, heap->summary_free, addr + size, addr + oldSize);
+		}
+		os_enablePreemption();
 		return addr;
 	}
 	
@@ -224,9 +590,11 @@ MemAddr os_realloc(Heap* heap, MemAddr addr, uint16_t size) {
 		} else {
 			if (after >= addr + size - 1) {
 				for (MemAddr i = addr + oldSize; i <= after; i++) {
-					setMapEntry(heap, i, 0xF);
+					setMapEntry(heap, i, HEAP_MAP_CONTINUATION);
 				}
-				os_leaveCriticalSection();
+				os_freeIndexTake(heap, addr + oldSize, size - oldSize);
+				os_summaryMarkRange(heap, heap->summary_cont, addr + oldSize, addr + size);
+				os_enablePreemption();
 				return addr;
 			}
 		}
@@ -239,8 +607,12 @@ MemAddr os_realloc(Heap* heap, MemAddr addr, uint16_t size) {
 	}
 	before++;
 	if (after - before >= size) {
+		// The old chunk joins the free blocks around it before the new one is
+		// cut out, while the map still shows its neighbours
+		os_freeIndexGive(heap, addr, oldSize);
 		moveChunk(heap, addr, oldSize, before, size);
-		os_leaveCriticalSection();
+		os_freeIndexTake(heap, before, size);
+		os_enablePreemption();
 		return before;
 	}
 
@@ -248,11 +620,311 @@ MemAddr os_realloc(Heap* heap, MemAddr addr, uint16_t size) {
 	// Finding any free chunk
 	MemAddr newChunk = os_malloc(heap, size);
 	if(newChunk != 0) {
-		moveChunk(heap, addr, oldSize, newChunk, size);
-		os_leaveCriticalSection();
+		os_copyWithin(heap, newChunk, addr, oldSize);
+		os_freeOwnerRestricted(heap, addr, os_getCurrentProc());
+		os_enablePreemption();
 		return newChunk;
 	}
 	
-	os_leaveCriticalSection();
+	os_enablePreemption();
 	return 0;
-}
\ No newline at end of file
+}
+
+//----------------------------------------------------------------------------
+// Shared memory
+//----------------------------------------------------------------------------
+
+//! Value of ShOpen.opens for a chunk that is opened for writing
+#define SH_OPEN_WRITE 0xFF
+
+//! A shared chunk that is opened by a process
+typedef struct ShOpen {
+	MemAddr chunk;   //!< First byte of the chunk
+	uint8_t heap;    //!< Index of the heap of the chunk (see os_lookupHeap)
+	uint8_t opens;   //!< Number of read opens, SH_OPEN_WRITE or 0 if unused
+} ShOpen;
+
+//! Shared chunks opened by every process, so they can be closed when it is killed
+ShOpen os_shOpens[MAX_NUMBER_OF_PROCESSES][HEAP_SH_OPENS_PER_PROCESS];
+
+/*!
+ *  \param heap A heap of the heap list.
+ *  \return The index of the heap in the heap list.
+ */
+static uint8_t os_sh_heapIndex(Heap const* heap) {
+	uint8_t index = 0;
+	while (index < os_getHeapListLength() - 1 && os_lookupHeap(index) != heap) {
+		index++;
+	}
+	return index;
+}
+
+/*!
+ *  Looks up the record of a shared chunk opened by a process.
+ *
+ *  \param pid The process.
+ *  \param heap The index of the heap of the chunk.
+ *  \param chunk The first byte of the chunk.
+ *  \param allocate Whether an unused record is returned if there is none for the chunk.
+ *  \return The record or NULL if there is none.
+ */
+static ShOpen* os_sh_findOpen(ProcessID pid, uint8_t heap, MemAddr chunk, bool allocate) {
+	ShOpen* unused = NULL;
+	for (uint8_t i = 0; i < HEAP_SH_OPENS_PER_PROCESS; i++) {
+		ShOpen* record = &os_shOpens[pid][i];
+		if (record->opens == 0) {
+			if (unused == NULL) {
+				unused = record;
+			}
+		} else if (record->heap == heap && record->chunk == chunk) {
+			return record;
+		}
+	}
+	return allocate ? unused : NULL;
+}
+
+/*!
+ *  Blocks the current process until any shared chunk is closed or freed.
+ *  Must be called within a critical section, the caller checks the chunk
+ *  again after it is woken up. The idle process must always be ready, so it
+ *  only yields.
+ */
+static void os_sh_wait(void) {
+	ProcessID pid = os_getCurrentProc();
+	if (pid != 0) {
+		os_shWaiters |= PROCESS_BIT(pid);
+		os_getProcessSlot(pid)->state = OS_PS_BLOCKED;
+		os_readyMask &= ~PROCESS_BIT(pid);
+	}
+	os_yield();
+}
+
+/*!
+ *  Makes all processes ready that wait for a shared chunk. Must be called
+ *  within a critical section.
+ */
+static void os_sh_wakeWaiters(void) {
+	for (ProcessID pid = 1; pid < MAX_NUMBER_OF_PROCESSES; pid++) {
+		if (os_shWaiters & PROCESS_BIT(pid)) {
+			os_getProcessSlot(pid)->state = OS_PS_READY;
+		}
+	}
+	os_readyMask |= os_shWaiters;
+	os_shWaiters = 0;
+}
+
+/*!
+ *  Opens a shared chunk for reading or writing. Blocks while the chunk is
+ *  opened for writing, by the maximum number of readers or (for writing) by
+ *  any reader. The pointer is dereferenced again after every wakeup, so it
+ *  may be redirected to another chunk in the meantime. The open is recorded
+ *  for the current process, which may have up to HEAP_SH_OPENS_PER_PROCESS
+ *  different chunks opened at once.
+ *
+ *  \param heap The heap the chunk resides in.
+ *  \param ptr Pointer to an address within the chunk.
+ *  \param write Whether the chunk is opened for writing.
+ *  \param chunk Receives the first byte of the opened chunk (0 on error).
+ *  \return The dereferenced ptr after opening the chunk.
+ */
+static MemAddr os_sh_open(Heap const* heap, MemAddr const* ptr, bool write, MemAddr* chunk) {
+	os_enterCriticalSection();
+	for (;;) {
+		MemAddr addr = *ptr;
+		MemAddr start = os_getFirstByteOfChunk(heap, addr);
+		MemValue entry = (start != 0) ? os_getMapEntry(heap, start) : 0;
+		if (!HEAP_MAP_IS_SHARED(entry)) {
+			os_error("No shared memory");
+			*chunk = 0;
+			os_leaveCriticalSection();
+			return 0;
+		}
+		if (write ? entry == HEAP_MAP_SH_CLOSED : entry < HEAP_MAP_SH_READ(HEAP_MAP_SH_MAX_READERS)) {
+			uint8_t const index = os_sh_heapIndex(heap);
+			ShOpen* record = os_sh_findOpen(os_getCurrentProc(), index, start, true);
+			if (record == NULL) {
+				os_error("Too many shared opens");
+				*chunk = 0;
+				os_leaveCriticalSection();
+				return 0;
+			}
+			setMapEntry(heap, start, write ? HEAP_MAP_SH_WRITE : entry + 1);
+			record->chunk = start;
+			record->heap = index;
+			record->opens = write ? SH_OPEN_WRITE : record->opens + 1;
+			*chunk = start;
+			os_leaveCriticalSection();
+			return addr;
+		}
+		os_sh_wait();
+	}
+}
+
+/*!
+ *  Allocates a shared chunk. It does not belong to any process, so it is not
+ *  freed when its creator terminates and has to be freed with os_sh_free.
+ *
+ *  \param heap The heap to allocate on.
+ *  \param size The size of the chunk.
+ *  \return The first byte of the chunk or 0 if there is no room.
+ */
+MemAddr os_sh_malloc(Heap* heap, size_t size) {
+	return os_mallocOwner(heap, size, HEAP_MAP_SH_CLOSED);
+}
+
+/*!
+ *  Frees a shared chunk. Blocks until the chunk is closed by all processes
+ *  that opened it.
+ *
+ *  \param heap The heap the chunk resides in.
+ *  \param addr Pointer to an address within the chunk, dereferenced again after every wakeup.
+ */
+void os_sh_free(Heap* heap, MemAddr* addr) {
+	os_enterCriticalSection();
+	for (;;) {
+		MemAddr start = os_getFirstByteOfChunk(heap, *addr);
+		MemValue entry = (start != 0) ? os_getMapEntry(heap, start) : 0;
+		if (!HEAP_MAP_IS_SHARED(entry)) {
+			os_error("No shared memory");
+			break;
+		}
+		if (entry == HEAP_MAP_SH_CLOSED) {
+			os_freeOwnerRestricted(heap, start, HEAP_MAP_SH_CLOSED);
+			os_sh_wakeWaiters();
+			break;
+		}
+		os_sh_wait();
+	}
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Opens a shared chunk for reading. Up to HEAP_MAP_SH_MAX_READERS processes
+ *  may read a chunk at the same time. Blocks while the chunk is opened for
+ *  writing (also by the current process) or by the maximum number of readers.
+ *
+ *  \param heap The heap the chunk resides in.
+ *  \param ptr Pointer to an address within the chunk.
+ *  \return The dereferenced ptr after opening the chunk.
+ */
+MemAddr os_sh_readOpen(Heap const* heap, MemAddr const* ptr) {
+	MemAddr chunk;
+	return os_sh_open(heap, ptr, false, &chunk);
+}
+
+/*!
+ *  Opens a shared chunk for writing. Blocks while the chunk is opened in any
+ *  way (also by the current process).
+ *
+ *  \param heap The heap the chunk resides in.
+ *  \param ptr Pointer to an address within the chunk.
+ *  \return The dereferenced ptr after opening the chunk.
+ */
+MemAddr os_sh_writeOpen(Heap const* heap, MemAddr const* ptr) {
+	MemAddr chunk;
+	return os_sh_open(heap, ptr, true, &chunk);
+}
+
+/*!
+ *  Closes a shared chunk that the current process opened for reading or
+ *  writing and wakes all processes that wait for a shared chunk. The chunks
+ *  a process still has opened when it is killed are closed by
+ *  os_sh_releaseProcess.
+ *
+ *  \param heap The heap the chunk resides in.
+ *  \param addr An address within the chunk.
+ */
+void os_sh_close(Heap const* heap, MemAddr addr) {
+	os_enterCriticalSection();
+	MemAddr start = os_getFirstByteOfChunk(heap, addr);
+	MemValue entry = (start != 0) ? os_getMapEntry(heap, start) : 0;
+	ShOpen* record = HEAP_MAP_IS_SHARED(entry) ? os_sh_findOpen(os_getCurrentProc(), os_sh_heapIndex(heap), start, false) : NULL;
+	if (record == NULL || entry == HEAP_MAP_SH_CLOSED) {
+		os_error("Shared memory not opened");
+	} else {
+		setMapEntry(heap, start, entry == HEAP_MAP_SH_WRITE ? HEAP_MAP_SH_CLOSED : entry - 1);
+		record->opens = (record->opens == SH_OPEN_WRITE) ? 0 : record->opens - 1;
+		os_sh_wakeWaiters();
+	}
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Closes all shared chunks a killed process still has opened and wakes all
+ *  processes that wait for a shared chunk. The process itself is no longer
+ *  made ready if it waited for a shared chunk.
+ *
+ *  \param pid The killed process.
+ */
+void os_sh_releaseProcess(ProcessID pid) {
+	os_enterCriticalSection();
+	os_shWaiters &= ~PROCESS_BIT(pid);
+	bool released = false;
+	for (uint8_t i = 0; i < HEAP_SH_OPENS_PER_PROCESS; i++) {
+		ShOpen* record = &os_shOpens[pid][i];
+		if (record->opens == 0) {
+			continue;
+		}
+		Heap const* heap = os_lookupHeap(record->heap);
+		MemValue entry = os_getMapEntry(heap, record->chunk);
+		setMapEntry(heap, record->chunk, record->opens == SH_OPEN_WRITE ? HEAP_MAP_SH_CLOSED : entry - record->opens);
+		record->opens = 0;
+		released = true;
+	}
+	if (released) {
+		os_sh_wakeWaiters();
+	}
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Copies a range of SRAM into a shared chunk. The chunk is opened for
+ *  writing once for the whole range. Nothing is written if the range exceeds
+ *  the chunk.
+ *
+ *  \param heap The heap the chunk resides in.
+ *  \param ptr Pointer to an address within the chunk.
+ *  \param offset The offset of the range from the first byte of the chunk.
+ *  \param dataSrc The data to write (in internal SRAM).
+ *  \param length The number of bytes to write.
+ */
+void os_sh_write(Heap const* heap, MemAddr const* ptr, uint16_t offset, MemValue const* dataSrc, uint16_t length) {
+	MemAddr chunk;
+	os_sh_open(heap, ptr, true, &chunk);
+	if (chunk == 0) {
+		return;
+	}
+	uint16_t size = os_getChunkSize(heap, chunk);
+	if (offset > size || length > size - offset) {
+		os_error("Shared write out of bounds");
+	} else {
+		heap->driver->writeBlock(chunk + offset, dataSrc, length);
+	}
+	os_sh_close(heap, chunk);
+}
+
+/*!
+ *  Copies a range of a shared chunk into SRAM. The chunk is opened for
+ *  reading once for the whole range. Nothing is read if the range exceeds
+ *  the chunk.
+ *
+ *  \param heap The heap the chunk resides in.
+ *  \param ptr Pointer to an address within the chunk.
+ *  \param offset The offset of the range from the first byte of the chunk.
+ *  \param dataDest The buffer for the data (in internal SRAM).
+ *  \param length The number of bytes to read.
+ */
+void os_sh_read(Heap const* heap, MemAddr const* ptr, uint16_t offset, MemValue* dataDest, uint16_t length) {
+	MemAddr chunk;
+	os_sh_open(heap, ptr, false, &chunk);
+	if (chunk == 0) {
+		return;
+	}
+	uint16_t size = os_getChunkSize(heap, chunk);
+	if (offset > size || length > size - offset) {
+		os_error("Shared read out of bounds");
+	} else {
+		heap->driver->readBlock(chunk + offset, dataDest, length);
+	}
+	os_sh_close(heap, chunk);
+}
@@ -3,36 +3,24 @@
 #include "os_core.h"
 
 MemAddr os_Memory_FirstFit(Heap *heap, size_t size) {
-	MemAddr addr;
-	size_t current_size = 0;
-	for (addr = heap->use_start; addr < heap->use_start + heap->use_size; addr++) {
-		if (os_getMapEntry(heap, addr) == 0) {
-			current_size++;
-			if (current_size >= size) {
-				return addr - current_size + 1;
-			}
-		} else {
-			current_size = 0;
+	FreeBlock block;
+	for (MemAddr from = heap->use_start; os_getNextFreeBlock(heap, from, &block); from = block.start + block.length) {
+		if (block.length >= size) {
+			return block.start;
 		}
 	}
 	return 0;
 }
 
 MemAddr os_Memory_NextFit(Heap *heap, size_t size) {
-	MemAddr address;
-	size_t current_size = 0;
-	for (address = heap->last_addr; address < heap->use_start + heap->use_size; address++) {
-		if (os_getMapEntry(heap, address) == 0) {
-			current_size++;
-			if (current_size >= size) {
-				heap->last_addr = address + 1;
-				return address - current_size + 1;
-			}
-		} else {
-			current_size = 0;
+	FreeBlock block;
+	for (MemAddr from = heap->last_addr; os_getNextFreeBlock(heap, from, &block); from = block.start + block.length) {
+		if (block.length >= size) {
+			heap->last_addr = block.start + size;
+			return block.start;
 		}
 	}
-	address = os_Memory_FirstFit(heap, size);
+	MemAddr address = os_Memory_FirstFit(heap, size);
 	if (address != 0) {
 		heap->last_addr = address + size;
 		return address;
@@ -41,49 +29,29 @@ MemAddr os_Memory_NextFit(Heap *heap, size_t size) {
 }
 
 MemAddr os_Memory_BestFit(Heap *heap, size_t size) {
-	MemAddr address;
-	size_t current_size = 0;
+	FreeBlock block;
 	MemAddr best_addr = 0;
 	uint16_t best_size = 0xFFFF;
-	for (address = heap->use_start; address < heap->use_start + heap->use_size; address++) {
-		if (os_getMapEntry(heap, address) == 0) {
-			current_size++;
-		} else {
-			if(current_size == size) {
-				return address - current_size;	
-			}else if (current_size > size && current_size < best_size) {
-				best_addr = address - current_size;
-				best_size = current_size;
-			}
-			current_size = 0;
+	for (MemAddr from = heap->use_start; os_getNextFreeBlock(heap, from, &block); from = block.start + block.length) {
+		if (block.length == size) {
+			return block.start;
+		} else if (block.length > size && block.length < best_size) {
+			best_addr = block.start;
+			best_size = block.length;
 		}
 	}
-	if (current_size >= size && current_size < best_size) {
-		best_addr = address - current_size;
-	}
 	return best_addr;
 }
 
 MemAddr os_Memory_WorstFit(Heap *heap, size_t size) {
-	MemAddr address;
-	size_t current_size = 0;
+	FreeBlock block;
 	MemAddr best_addr = 0;
 	size_t best_size = 0;
-	for (address = heap->use_start; address < heap->use_start + heap->use_size; address++) {
-		if (os_getMapEntry(heap, address) == 0) {
-			current_size++;
-		} else {
-			if(current_size >= size && current_size >= heap->use_size / 2) {
-				return address - current_size;
-			}else if (current_size >= size && current_size > best_size) {
-				best_addr = address - current_size;
-				best_size = current_size;
-			}
-			current_size = 0;
+	for (MemAddr from = heap->use_start; os_getNextFreeBlock(heap, from, &block); from = block.start + block.length) {
+		if (block.length >= size && block.length > best_size) {
+			best_addr = block.start;
+			best_size = block.length;
 		}
 	}
-	if (current_size >= size && current_size > best_size) {
-		best_addr = address - current_size;
-	}
 	return best_addr;
-}
\ No newline at end of file
+}
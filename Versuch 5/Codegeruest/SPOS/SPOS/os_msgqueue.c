@@ -0,0 +1,213 @@
+#include "os_msgqueue.h"
+#include "os_memory.h"
+#include "os_scheduler.h"
+#include "os_core.h"
+
+//----------------------------------------------------------------------------
+// Private functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  \param queue The queue.
+ *  \return The number of bytes one message occupies in the buffer.
+ */
+static uint8_t os_mqSlotSize(MessageQueue const* queue) {
+	return queue->messageSize == OS_MQ_CHUNKS ? sizeof(MemAddr) : queue->messageSize;
+}
+
+/*!
+ *  Reserves the slot the next message is written to. A free slot must have
+ *  been taken from freeSlots before and preemption must be disabled.
+ *
+ *  \param queue The queue.
+ *  \return The address of the slot within the heap.
+ */
+static MemAddr os_mqNextTail(MessageQueue* queue) {
+	MemAddr slot = queue->buffer + (uint16_t)queue->tail * os_mqSlotSize(queue);
+	if (++queue->tail == queue->capacity) {
+		queue->tail = 0;
+	}
+	return slot;
+}
+
+/*!
+ *  Releases the slot of the oldest message. A message must have been taken
+ *  from messages before and preemption must be disabled.
+ *
+ *  \param queue The queue.
+ *  \return The address of the slot within the heap.
+ */
+static MemAddr os_mqNextHead(MessageQueue* queue) {
+	MemAddr slot = queue->buffer + (uint16_t)queue->head * os_mqSlotSize(queue);
+	if (++queue->head == queue->capacity) {
+		queue->head = 0;
+	}
+	return slot;
+}
+
+//----------------------------------------------------------------------------
+// Function definitions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Creates a message queue. The buffer is allocated on the given heap and
+ *  belongs to the current process, so the queue must not be used anymore
+ *  after this process terminated.
+ *  With OS_MQ_CHUNKS as message size only the addresses of the chunks are
+ *  stored. The chunks themselves belong to the creator while they are in
+ *  the queue, so they are not lost if the sender terminates. They are freed
+ *  with the creator though, so it has to outlive every queued chunk. A
+ *  receiver that finds a chunk which is not owned by the creator anymore
+ *  reports an error.
+ *
+ *  \param queue The queue to initialize.
+ *  \param heap The heap for the buffer (and the passed chunks).
+ *  \param capacity The maximum number of messages in the queue (at least 1).
+ *  \param messageSize The size of a message in bytes or OS_MQ_CHUNKS.
+ *  \return True on success, false if the buffer could not be allocated.
+ */
+bool os_mqCreate(MessageQueue* queue, Heap* heap, uint8_t capacity, uint8_t messageSize) {
+	if (capacity == 0) {
+		return false;
+	}
+	queue->heap = heap;
+	queue->messageSize = messageSize;
+	queue->capacity = capacity;
+	queue->buffer = os_malloc(heap, (uint16_t)capacity * os_mqSlotSize(queue));
+	if (queue->buffer == 0) {
+		return false;
+	}
+	queue->head = 0;
+	queue->tail = 0;
+	queue->owner = os_getCurrentProc();
+	os_semaphoreInit(&queue->freeSlots, capacity);
+	os_semaphoreInit(&queue->messages, 0);
+	return true;
+}
+
+/*!
+ *  Frees the buffer of a queue and, in chunk mode, all chunks that are still
+ *  in the queue. May only be called by the creator and only if no process
+ *  waits for the queue anymore.
+ *
+ *  \param queue The queue to destroy.
+ */
+void os_mqDestroy(MessageQueue* queue) {
+	if (queue->owner != os_getCurrentProc()) {
+		os_error("Queue not owned by this process");
+		return;
+	}
+	os_disablePreemption();
+	if (queue->messageSize == OS_MQ_CHUNKS) {
+		while (os_semaphoreTryWait(&queue->messages)) {
+			MemAddr slot = os_mqNextHead(queue);
+			MemAddr chunk = queue->heap->driver->read(slot) | (queue->heap->driver->read(slot + 1) << 8);
+			os_free(queue->heap, chunk);
+		}
+	}
+	os_free(queue->heap, queue->buffer);
+	queue->buffer = 0;
+	os_enablePreemption();
+}
+
+/*!
+ *  Appends a copy of a message to the queue. If the queue is full, the
+ *  process is blocked until a message was received.
+ *
+ *  \param queue The queue.
+ *  \param message The message, messageSize bytes in SRAM.
+ */
+void os_mqSend(MessageQueue* queue, void const* message) {
+	if (queue->messageSize == OS_MQ_CHUNKS) {
+		os_error("Use os_mqSendChunk for this queue");
+		return;
+	}
+	os_semaphoreWait(&queue->freeSlots);
+	os_disablePreemption();
+	MemAddr slot = os_mqNextTail(queue);
+	queue->heap->driver->writeBlock(slot, message, queue->messageSize);
+	os_enablePreemption();
+	os_semaphoreSignal(&queue->messages);
+}
+
+/*!
+ *  Removes the oldest message from the queue and copies it. If the queue is
+ *  empty, the process is blocked until a message was sent.
+ *
+ *  \param queue The queue.
+ *  \param message The buffer for the message, messageSize bytes in SRAM.
+ */
+void os_mqReceive(MessageQueue* queue, void* message) {
+	if (queue->messageSize == OS_MQ_CHUNKS) {
+		os_error("Use os_mqReceiveChunk for this queue");
+		return;
+	}
+	os_semaphoreWait(&queue->messages);
+	os_disablePreemption();
+	MemAddr slot = os_mqNextHead(queue);
+	queue->heap->driver->readBlock(slot, message, queue->messageSize);
+	os_enablePreemption();
+	os_semaphoreSignal(&queue->freeSlots);
+}
+
+/*!
+ *  Passes a chunk to the queue without copying it. The chunk has to be
+ *  allocated by the current process on the heap of the queue and must not
+ *  be accessed by the sender anymore. If the queue is full, the process is
+ *  blocked until a message was received.
+ *
+ *  \param queue The queue (created with OS_MQ_CHUNKS).
+ *  \param chunk The first byte of the chunk.
+ *  \return False if the chunk is not (or no longer, after the process was
+ *          blocked) owned by the current process.
+ */
+bool os_mqSendChunk(MessageQueue* queue, MemAddr chunk) {
+	if (queue->messageSize != OS_MQ_CHUNKS) {
+		os_error("Use os_mqSend for this queue");
+		return false;
+	}
+	if (os_getFirstByteOfChunk(queue->heap, chunk) != chunk || (ProcessID) os_getMapEntry(queue->heap, chunk) != os_getCurrentProc()) {
+		return false;
+	}
+	os_semaphoreWait(&queue->freeSlots);
+	os_disablePreemption();
+	if (!os_transferChunk(queue->heap, chunk, os_getCurrentProc(), queue->owner)) {
+		os_enablePreemption();
+		os_semaphoreSignal(&queue->freeSlots);
+		return false;
+	}
+	MemAddr slot = os_mqNextTail(queue);
+	queue->heap->driver->write(slot, chunk & 0xFF);
+	queue->heap->driver->write(slot + 1, chunk >> 8);
+	os_enablePreemption();
+	os_semaphoreSignal(&queue->messages);
+	return true;
+}
+
+/*!
+ *  Removes the oldest chunk from the queue and makes the current process its
+ *  owner, so it has to free it eventually. If the queue is empty, the
+ *  process is blocked until a chunk was sent.
+ *
+ *  \param queue The queue (created with OS_MQ_CHUNKS).
+ *  \return The first byte of the chunk within the heap of the queue, or 0 if
+ *          the chunk was lost because the creator of the queue terminated.
+ */
+MemAddr os_mqReceiveChunk(MessageQueue* queue) {
+	if (queue->messageSize != OS_MQ_CHUNKS) {
+		os_error("Use os_mqReceive for this queue");
+		return 0;
+	}
+	os_semaphoreWait(&queue->messages);
+	os_disablePreemption();
+	MemAddr slot = os_mqNextHead(queue);
+	MemAddr chunk = queue->heap->driver->read(slot) | (queue->heap->driver->read(slot + 1) << 8);
+	bool const transferred = os_transferChunk(queue->heap, chunk, queue->owner, os_getCurrentProc());
+	os_enablePreemption();
+	os_semaphoreSignal(&queue->freeSlots);
+	if (!transferred) {
+		os_error("Queued chunk lost");
+		return 0;
+	}
+	return chunk;
+}
@@ -0,0 +1,64 @@
+/*! \file
+ *  \brief Bounded message queues for inter-process communication.
+ *
+ *  A message queue holds up to a fixed number of messages of a fixed size in
+ *  a buffer that is allocated from a heap. Sending to a full queue and
+ *  receiving from an empty queue block the process until the other side made
+ *  room or delivered a message.
+ *  A queue created with OS_MQ_CHUNKS as message size does not copy any data:
+ *  the messages are chunks of the heap of the queue whose ownership is passed
+ *  from the sender to the receiver.
+ */
+
+#ifndef _OS_MSGQUEUE_H
+#define _OS_MSGQUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "os_memheap_drivers.h"
+#include "os_sync.h"
+
+//! Message size of a queue that passes heap chunks instead of copying bytes
+#define OS_MQ_CHUNKS 0
+
+//----------------------------------------------------------------------------
+// Types
+//----------------------------------------------------------------------------
+
+//! A bounded FIFO queue of messages
+typedef struct MessageQueue {
+    Heap* heap;
+    MemAddr buffer;
+    uint8_t messageSize;
+    uint8_t capacity;
+    uint8_t head;
+    uint8_t tail;
+    ProcessID owner;
+    Semaphore freeSlots;
+    Semaphore messages;
+} MessageQueue;
+
+//----------------------------------------------------------------------------
+// Function headers
+//----------------------------------------------------------------------------
+
+//! Creates a queue for capacity messages of messageSize bytes (or OS_MQ_CHUNKS) on heap
+bool os_mqCreate(MessageQueue* queue, Heap* heap, uint8_t capacity, uint8_t messageSize);
+
+//! Frees the buffer of a queue and all chunks that were not received
+void os_mqDestroy(MessageQueue* queue);
+
+//! Copies a message into the queue, blocks while the queue is full
+void os_mqSend(MessageQueue* queue, void const* message);
+
+//! Copies the oldest message out of the queue, blocks while the queue is empty
+void os_mqReceive(MessageQueue* queue, void* message);
+
+//! Passes a chunk of the heap of the queue to the receiver, blocks while the queue is full
+bool os_mqSendChunk(MessageQueue* queue, MemAddr chunk);
+
+//! Takes over the oldest chunk of the queue, blocks while the queue is empty
+MemAddr os_mqReceiveChunk(MessageQueue* queue);
+
+#endif
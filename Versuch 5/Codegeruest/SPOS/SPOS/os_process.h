@@ -14,6 +14,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "os_mem_drivers.h"
+#include "defines.h"
+#include "util.h"
 
 //! The type for the ID of a running process.
 typedef uint8_t ProcessID;
@@ -30,6 +32,20 @@ typedef uint16_t Age;
 //! The type for the checksum used to check stack consistency.
 typedef uint8_t StackChecksum;
 
+//! A set of processes, bit n stands for the process with ID n.
+#if MAX_NUMBER_OF_PROCESSES <= 8
+typedef uint8_t ProcessMask;
+#elif MAX_NUMBER_OF_PROCESSES <= 16
+typedef uint16_t ProcessMask;
+#elif MAX_NUMBER_OF_PROCESSES <= 32
+typedef uint32_t ProcessMask;
+#else
+#error "MAX_NUMBER_OF_PROCESSES may be nothing > 32"
+#endif
+
+//! The element of a ProcessMask that stands for the process PID.
+#define PROCESS_BIT(PID) ((ProcessMask)1 << (PID))
+
 //! Type for the state a specific process is currently in.
 typedef enum ProcessState {
     OS_PS_UNUSED,
@@ -49,6 +65,8 @@ typedef union StackPointer {
  *  The struct that holds all information for a process.
  *  Note that additional scheduling information (such as the current time-slice)
  *  are stored by the module that implements the actual scheduling strategies.
+ *  Properties that are only used by the scheduler itself (stack bounds, saved
+ *  nesting depths, accounting) are kept in dense arrays in os_scheduler.c.
  */
 typedef struct {
     ProgramID progID;
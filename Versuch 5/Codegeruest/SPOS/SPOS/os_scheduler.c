@@ -7,8 +7,11 @@
 #include "lcd.h"
 #include "os_memory.h"
 #include "os_memheap_drivers.h"
+#include "os_trace.h"
+#include "os_sync.h"
 
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
 
 //----------------------------------------------------------------------------
 // Private Types
@@ -27,19 +30,129 @@ Program* os_programs[MAX_NUMBER_OF_PROGRAMS];
 //! Index of process that is currently executed (default: idle)
 ProcessID currentProc;
 
+//! Set of processes that are ready or running
+ProcessMask os_readyMask;
+
+//----------------------------------------------------------------------------
+// Per-process scheduler data
+//----------------------------------------------------------------------------
+
+// Properties of the processes that only the scheduler needs are kept in one
+// dense array per property instead of in os_processes, so os_processes stays
+// small. The switch path finds an entry of a byte array with a single add and
+// one of a wider array with a shift and an add, instead of multiplying the pid
+// with the size of a Process.
+
+//! Copy of the priority of every process that is read by the strategies
+Priority os_procPriority[MAX_NUMBER_OF_PROCESSES];
+
+//! Bottom of the stack of every process. That is the highest address.
+StackPointer os_procStackBottom[MAX_NUMBER_OF_PROCESSES];
+
+//! Size of the stack of every process
+uint16_t os_procStackSize[MAX_NUMBER_OF_PROCESSES];
+
+//! Nesting depth of critical sections of every suspended process
+uint8_t os_procCriticalSections[MAX_NUMBER_OF_PROCESSES];
+
+//! Nesting depth of os_disablePreemption of every suspended process
+uint8_t os_procPreemptionCount[MAX_NUMBER_OF_PROCESSES];
+
+//! Whether the context of every suspended process was saved by os_yield
+bool os_procYielded[MAX_NUMBER_OF_PROCESSES];
+
+//! Processor time used by every process since the accounting was reset
+Time os_procCpuTime[MAX_NUMBER_OF_PROCESSES];
+
+//! Number of switches to every process since the accounting was reset
+uint16_t os_procSwitches[MAX_NUMBER_OF_PROCESSES];
+
+//! Set of processes started by os_execPeriodic
+ProcessMask os_periodicMask;
+
+//! Period of every periodic process (in system time units)
+Time os_procPeriod[MAX_NUMBER_OF_PROCESSES];
+
+//! Deadline of every periodic process relative to its release (in system time units)
+Time os_procRelativeDeadline[MAX_NUMBER_OF_PROCESSES];
+
+//! Release time of the current job of every periodic process
+Time os_procRelease[MAX_NUMBER_OF_PROCESSES];
+
+//! Absolute deadline of the current job of every periodic process
+Time os_procDeadline[MAX_NUMBER_OF_PROCESSES];
+
+//! Number of jobs of every periodic process that completed after their deadline
+uint16_t os_procDeadlineMisses[MAX_NUMBER_OF_PROCESSES];
+
 //----------------------------------------------------------------------------
 // Private variables
 //----------------------------------------------------------------------------
 
+#ifdef OS_FIXED_SCHEDULING_STRATEGY
+//! The scheduling strategy is fixed at compile time
+#define currentSchedStrat ((SchedulingStrategy)(OS_FIXED_SCHEDULING_STRATEGY))
+#else
 //! Currently active scheduling strategy
 SchedulingStrategy currentSchedStrat;
+#endif
 
 //! Count of currently nested critical sections
 uint8_t criticalSectionCount;
 
+//! Count of currently nested os_disablePreemption calls
+uint8_t preemptionCount;
+
+//! Set if a scheduler tick was deferred because preemption was disabled
+bool preemptionPending;
+
+//! System time the currently deferred tick occurred
+Time preemptionHoldOffStart;
+
+//! Longest time a tick was deferred
+Time preemptionMaxHoldOff;
+
 //! Used to auto-execute programs.
 uint16_t os_autostart;
 
+//! First process of the delta queue of sleeping processes
+ProcessID os_sleepHead;
+
+//! Successor of every sleeping process in the delta queue
+ProcessID os_sleepNext[MAX_NUMBER_OF_PROCESSES];
+
+//! Time a sleeping process has to wait after its predecessor woke up
+Time os_sleepDelta[MAX_NUMBER_OF_PROCESSES];
+
+//! System time the delta of the first sleeping process refers to
+Time os_sleepUpdated;
+
+//! System time the last scheduling decision was completed
+Time os_lastSwitch;
+
+//! Processor time spent in the scheduler since the accounting was reset
+Time os_schedulerTime;
+
+//! System time the accounting was reset
+Time os_accountingStart;
+
+#if OS_CYCLE_PROBE
+//! Cycles spent in every measured part of the switch since the accounting was reset
+uint32_t os_probeCycles[OS_PROBE_COUNT];
+
+//! Number of switches measured since the accounting was reset
+uint16_t os_probeSamples;
+#endif
+
+//! Compare value of timer 2, i.e. the length of a tick
+uint8_t os_tickCompare = SCHEDULER_TICK_COMPARE;
+
+//! Set if the task manager hot key was pressed
+volatile bool os_taskManRequested;
+
+//! The process of the task manager (if it is running)
+ProcessID os_taskManProc = INVALID_PROCESS;
+
 //----------------------------------------------------------------------------
 // Private function declarations
 //----------------------------------------------------------------------------
@@ -47,10 +160,241 @@ uint16_t os_autostart;
 //! ISR for timer compare match (scheduler)
 ISR(TIMER2_COMPA_vect) __attribute__((naked));
 
+//! Voluntary context switch, saves its own context
+void os_yield(void) __attribute__((naked));
+
+//! ISR for pin changes of the buttons (task manager hot key)
+ISR(PCINT2_vect);
+
 //----------------------------------------------------------------------------
 // Function definitions
 //----------------------------------------------------------------------------
 
+/*!
+ *  Charges the time passed since the last update to the first sleeping
+ *  process and wakes up all processes whose sleeping time is over. As the
+ *  queue stores the delays relative to the predecessor, only the processes
+ *  that are actually woken up have to be visited.
+ *
+ *  \param now The current system time.
+ */
+static void os_updateSleepQueue(Time now) {
+	Time elapsed = now - os_sleepUpdated;
+	os_sleepUpdated = now;
+	
+	while (os_sleepHead != INVALID_PROCESS) {
+		if (os_sleepDelta[os_sleepHead] > elapsed) {
+			os_sleepDelta[os_sleepHead] -= elapsed;
+			return;
+		}
+		elapsed -= os_sleepDelta[os_sleepHead];
+		os_processes[os_sleepHead].state = OS_PS_READY;
+		os_readyMask |= PROCESS_BIT(os_sleepHead);
+		os_sleepHead = os_sleepNext[os_sleepHead];
+	}
+}
+
+/*!
+ *  Removes a process from the queue of sleeping processes (if it is in there).
+ *  Its remaining delay is handed to its successor.
+ *
+ *  \param pid The process to remove.
+ */
+static void os_removeSleeper(ProcessID pid) {
+	ProcessID* link = &os_sleepHead;
+	while (*link != INVALID_PROCESS) {
+		if (*link == pid) {
+			*link = os_sleepNext[pid];
+			if (*link != INVALID_PROCESS) {
+				os_sleepDelta[*link] += os_sleepDelta[pid];
+			}
+			return;
+		}
+		link = &os_sleepNext[*link];
+	}
+}
+
+#ifdef OS_FIXED_SCHEDULING_STRATEGY
+/*!
+ *  Calls the select function of the fixed strategy. The switch is on a
+ *  constant, so only a direct call remains instead of the descriptor lookup
+ *  and the indirect call through it.
+ *
+ *  \param current The id of the current process.
+ *  \return The next process to be executed.
+ */
+static inline ProcessID os_selectFixed(ProcessID current) {
+	switch (OS_FIXED_SCHEDULING_STRATEGY) {
+		case OS_SS_EVEN: return os_Scheduler_Even(os_processes, current);
+		case OS_SS_RANDOM: return os_Scheduler_Random(os_processes, current);
+		case OS_SS_RUN_TO_COMPLETION: return os_Scheduler_RunToCompletion(os_processes, current);
+		case OS_SS_ROUND_ROBIN: return os_Scheduler_RoundRobin(os_processes, current);
+		case OS_SS_INACTIVE_AGING: return os_Scheduler_InactiveAging(os_processes, current);
+		case OS_SS_MULTI_LEVEL_FEEDBACK_QUEUE: return os_Scheduler_MLFQ(os_processes, current);
+		case OS_SS_STRIDE: return os_Scheduler_Stride(os_processes, current);
+		case OS_SS_EARLIEST_DEADLINE_FIRST: return os_Scheduler_EDF(os_processes, current);
+	}
+	return current;
+}
+#endif
+
+/*!
+ *  Returns the current count of the cycle counter (timer 1), if the
+ *  cycle probe is enabled.
+ *
+ *  \return The number of cycles modulo 2^16.
+ */
+static inline uint16_t os_probeStart(void) {
+#if OS_CYCLE_PROBE
+	return TCNT1;
+#else
+	return 0;
+#endif
+}
+
+/*!
+ *  Charges the cycles since start to a measured part of the switch, if the
+ *  cycle probe is enabled. A single measurement must not exceed 2^16 cycles.
+ *
+ *  \param probe The measured part.
+ *  \param start The count returned by os_probeStart.
+ */
+static inline void os_probeStop(CycleProbe probe, uint16_t start) {
+#if OS_CYCLE_PROBE
+	os_probeCycles[probe] += (uint16_t)(TCNT1 - start);
+#else
+	(void)probe;
+	(void)start;
+#endif
+}
+
+/*!
+ *  Selects the next process for execution. Must be called on the ISR stack
+ *  after the context of the current process has been saved. The stack state and
+ *  the critical section nesting of the suspended process are recorded, the
+ *  next process is derived with an exchangeable strategy and its critical
+ *  section nesting is reinstated. Every actual switch is recorded in the trace.
+ *  The time since the last decision is charged to the suspended process and
+ *  the time of the decision itself to the scheduler.
+ *
+ *  If the task manager was requested, it is started and chosen without
+ *  asking the strategy.
+ *
+ *  \param yield Whether the current process gave up the processor voluntarily.
+ *                In this case it is hidden from the strategy as long as some
+ *                other process (besides idle) is ready.
+ */
+static void os_switchProcess(bool yield) {
+	// The task manager is dispatched directly, whatever the strategy thinks of its priority
+	bool taskMan = false;
+	if (os_taskManRequested) {
+		os_taskManRequested = false;
+		os_startTaskMan();
+		taskMan = os_taskManProc != INVALID_PROCESS && (os_readyMask & PROCESS_BIT(os_taskManProc));
+	}
+	
+	Time now = getSystemTime();
+	os_procCpuTime[currentProc] += now - os_lastSwitch;
+	
+	if (preemptionPending) {
+		// A deferred tick, even if it was finally triggered by os_yield
+		preemptionPending = false;
+		yield = false;
+		if (now - preemptionHoldOffStart > preemptionMaxHoldOff) {
+			preemptionMaxHoldOff = now - preemptionHoldOffStart;
+		}
+	}
+	os_updateSleepQueue(now);
+	
+	ProcessID const previous = currentProc;
+	SwitchReason reason = yield ? OS_SR_YIELD : OS_SR_TICK;
+	if (os_processes[currentProc].state == OS_PS_UNUSED) {
+		reason = OS_SR_KILL;
+	} else if (os_processes[currentProc].state == OS_PS_BLOCKED) {
+		reason = OS_SR_BLOCK;
+	}
+	
+	uint16_t probe = os_probeStart();
+#if STACK_CHECK_MODE == STACK_CHECK_CANARY
+	if (!os_isStackCanaryIntact(currentProc)) {
+		os_error("Stack Overflow");
+	}
+#else
+	os_processes[currentProc].checksum = os_getStackChecksum(currentProc);
+#endif
+	os_probeStop(OS_PROBE_STACK_CHECK, probe);
+	os_procCriticalSections[currentProc] = criticalSectionCount;
+	os_procPreemptionCount[currentProc] = preemptionCount;
+	os_procPriority[currentProc] = os_processes[currentProc].priority;
+	
+	if (os_processes[currentProc].state == OS_PS_RUNNING) { // Making sure currentProc wasn't terminated
+		os_processes[currentProc].state = OS_PS_READY;
+	}
+	
+	ProcessMask hidden = 0;
+	if (yield && (os_readyMask & ~(PROCESS_BIT(0) | PROCESS_BIT(currentProc)))) {
+		hidden = os_readyMask & PROCESS_BIT(currentProc);
+		os_readyMask &= ~hidden;
+	}
+	
+	if (taskMan) {
+		currentProc = os_taskManProc;
+	} else {
+		probe = os_probeStart();
+#ifdef OS_FIXED_SCHEDULING_STRATEGY
+		currentProc = os_selectFixed(currentProc);
+#else
+		currentProc = os_schedulingStrategies[currentSchedStrat]->select(os_processes, currentProc);
+#endif
+		os_probeStop(OS_PROBE_SELECT, probe);
+	}
+	
+	os_readyMask |= hidden;
+	os_processes[currentProc].state = OS_PS_RUNNING;
+	
+	if (currentProc != previous) {
+		os_procSwitches[currentProc]++;
+		os_traceSwitch(now, previous, currentProc, currentSchedStrat, reason);
+	}
+	
+	probe = os_probeStart();
+#if STACK_CHECK_MODE == STACK_CHECK_CANARY
+	if (!os_isStackCanaryIntact(currentProc)) {
+#else
+	if (os_processes[currentProc].checksum != os_getStackChecksum(currentProc)) {
+#endif
+		os_error("Stack Inconsitency");
+	}
+	os_probeStop(OS_PROBE_STACK_CHECK, probe);
+#if OS_CYCLE_PROBE
+	os_probeSamples++;
+#endif
+	
+	criticalSectionCount = os_procCriticalSections[currentProc];
+	preemptionCount = os_procPreemptionCount[currentProc];
+	if (criticalSectionCount) {
+		cbi(TIMSK2, OCIE2A);
+	} else {
+		sbi(TIMSK2, OCIE2A);
+	}
+	
+	os_lastSwitch = getSystemTime();
+	os_schedulerTime += os_lastSwitch - now;
+	
+#if OS_TICKLESS_IDLE
+	// Idle only runs if nothing else is ready, so it only has to be preempted
+	// when the next sleeping process is due
+	if (currentProc != 0) {
+		OCR2A = os_tickCompare;
+	} else if (os_sleepHead != INVALID_PROCESS && os_sleepDelta[os_sleepHead] < 0xFFul * (TC2_PRESCALER / TC0_PRESCALER)) {
+		uint8_t compare = os_sleepDelta[os_sleepHead] / (TC2_PRESCALER / TC0_PRESCALER);
+		OCR2A = compare ? compare : 1;
+	} else {
+		OCR2A = 0xFF;
+	}
+#endif
+}
+
 /*!
  *  Timer interrupt that implements our scheduler. Execution of the running
  *  process is suspended and the context saved to the stack. Then the periphery
@@ -62,37 +406,91 @@ ISR(TIMER2_COMPA_vect) __attribute__((naked));
 ISR(TIMER2_COMPA_vect) {
 	saveContext();
 	
+	// The switch is done as soon as preemption is enabled again
+	if (preemptionCount) {
+		if (!preemptionPending) {
+			preemptionPending = true;
+			preemptionHoldOffStart = getSystemTime();
+		}
+		restoreContext();
+	}
+	
 	os_processes[currentProc].sp.as_int = SP;
+	os_procYielded[currentProc] = false;
 	
 	SP = BOTTOM_OF_ISR_STACK;
 	
+	os_switchProcess(false);
+	
+	SP = os_processes[currentProc].sp.as_int;
+	
+	if (os_procYielded[currentProc]) {
+		restoreYieldContext();
+	}
+	restoreContext();
+}
+
+/*!
+ *  Pin change interrupt of the buttons. If Enter and ESC are pressed at the
+ *  same time, the task manager is started and switched to with the next
+ *  scheduling decision.
+ *  This way the scheduler does not have to poll the buttons on every tick.
+ */
+ISR(PCINT2_vect) {
 	if (os_getInput() == 0b00001001) {
-		os_waitForNoInput();
-		os_taskManMain();
+		os_taskManRequested = true;
 	}
+}
 
-	os_processes[currentProc].checksum = os_getStackChecksum(currentProc);
-	
-	if (os_processes[currentProc].state == OS_PS_RUNNING) { // Making sure currentProc wasn't terminated
-		os_processes[currentProc].state = OS_PS_READY;
+/*!
+ *  The program of the task manager process.
+ */
+static void os_taskManProgram(void) {
+	os_waitForNoInput();
+	os_taskManMain();
+}
+
+/*!
+ *  Starts the task manager as a process with TASKMAN_PRIORITY, unless it is
+ *  already running. Other processes keep running while the task manager is
+ *  open. After the first switch to it, the active strategy decides like for
+ *  every other process how much processor time it gets. If there is no free
+ *  process slot, the request is dropped.
+ */
+void os_startTaskMan(void) {
+	os_enterCriticalSection();
+	if (os_taskManProc == INVALID_PROCESS || os_processes[os_taskManProc].state == OS_PS_UNUSED || os_processes[os_taskManProc].progID != TASKMAN_PROGRAM) {
+		os_taskManProc = os_execWithStack(TASKMAN_PROGRAM, TASKMAN_PRIORITY, STACK_SIZE_TASKMAN);
 	}
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Immediately hands the processor to the next process instead of waiting for
+ *  the end of the time slice. As this is a regular function call, only the
+ *  call-saved registers and SREG are saved. The process is resumed with its
+ *  global interrupt flag and its critical section nesting unchanged, so it may
+ *  even yield from within a critical section. The next process starts with a
+ *  fresh time slice.
+ */
+void os_yield(void) {
+	saveYieldContext();
 	
-	switch(currentSchedStrat) {
-		case OS_SS_EVEN: currentProc = os_Scheduler_Even(os_processes, currentProc); break;
-		case OS_SS_RANDOM: currentProc = os_Scheduler_Random(os_processes, currentProc); break;
-		case OS_SS_ROUND_ROBIN: currentProc = os_Scheduler_RoundRobin(os_processes, currentProc); break;
-		case OS_SS_INACTIVE_AGING: currentProc = os_Scheduler_InactiveAging(os_processes, currentProc); break;
-		case OS_SS_RUN_TO_COMPLETION: currentProc = os_Scheduler_RunToCompletion(os_processes, currentProc); break;
-	}
+	os_processes[currentProc].sp.as_int = SP;
+	os_procYielded[currentProc] = true;
 	
-	os_processes[currentProc].state = OS_PS_RUNNING;
+	SP = BOTTOM_OF_ISR_STACK;
 	
-	if (os_processes[currentProc].checksum != os_getStackChecksum(currentProc)) {
-		os_error("Stack Inconsitency");
-	}
+	os_switchProcess(true);
+	
+	TCNT2 = 0;
+	TIFR2 = (1 << OCF2A);
 	
 	SP = os_processes[currentProc].sp.as_int;
 	
+	if (os_procYielded[currentProc]) {
+		restoreYieldContext();
+	}
 	restoreContext();
 }
 
@@ -107,16 +505,157 @@ bool os_kill(ProcessID pid) {
 	if (pid == 0) return false;
 	os_enterCriticalSection();
 	os_processes[pid].state = OS_PS_UNUSED;
+	os_readyMask &= ~PROCESS_BIT(pid);
+	os_periodicMask &= ~PROCESS_BIT(pid);
+	MLFQ_removePID(pid);
+	os_removeSleeper(pid);
+	os_syncReleaseProcess(pid);
+	os_sh_releaseProcess(pid);
 	os_freeProcessMemory(intHeap, pid);
 	os_freeProcessMemory(extHeap, pid);
 	if (pid == currentProc) {
 		criticalSectionCount = 1; // This ensures that this program has no critical sections left.
 	}
 	os_leaveCriticalSection();
-	while (pid == currentProc);
+	if (pid == currentProc) {
+		os_yield();
+	}
 	return true;
 }
 
+/*!
+ *  Converts milliseconds to system time units (see getSystemTime).
+ *
+ *  \param ms The time in milliseconds.
+ *  \return The time in system time units.
+ */
+static Time os_msToSystemTime(uint16_t ms) {
+	return ((Time)ms * (F_CPU / 1000ul)) / TC0_PRESCALER;
+}
+
+/*!
+ *  Inserts the current process into the delta queue of sleeping processes
+ *  and gives up the processor. Must be called within a critical section,
+ *  which is kept across the yield, so the process cannot be woken up before
+ *  it actually gave up the processor.
+ *
+ *  \param now The current system time.
+ *  \param delta The time to sleep in system time units.
+ */
+static void os_sleepFor(Time now, Time delta) {
+	os_updateSleepQueue(now);
+	
+	ProcessID* link = &os_sleepHead;
+	while (*link != INVALID_PROCESS && os_sleepDelta[*link] <= delta) {
+		delta -= os_sleepDelta[*link];
+		link = &os_sleepNext[*link];
+	}
+	if (*link != INVALID_PROCESS) {
+		os_sleepDelta[*link] -= delta;
+	}
+	os_sleepNext[currentProc] = *link;
+	os_sleepDelta[currentProc] = delta;
+	*link = currentProc;
+	
+	os_processes[currentProc].state = OS_PS_BLOCKED;
+	os_readyMask &= ~PROCESS_BIT(currentProc);
+	
+	os_yield();
+}
+
+/*!
+ *  Blocks the current process for (at least) the given time. The process is
+ *  inserted into the delta queue of sleeping processes, which is sorted by
+ *  wakeup time, and gives up the processor. The scheduler wakes it up again
+ *  with the first scheduling decision after the time has passed. The idle
+ *  process must always be ready, so it (and the init code) only waits actively.
+ *
+ *  \param ms The time to sleep in milliseconds (max. 65535).
+ */
+void os_sleep(uint16_t ms) {
+	if (currentProc == 0) {
+		delayMs(ms);
+		return;
+	}
+	
+	os_enterCriticalSection();
+	os_sleepFor(getSystemTime(), os_msToSystemTime(ms));
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Starts a periodic process, whose jobs are released every period
+ *  milliseconds starting now. The process runs its jobs in a loop and calls
+ *  os_waitForNextPeriod at the end of every job. The EDF strategy runs the
+ *  ready periodic process with the nearest absolute deadline (release plus
+ *  the relative deadline) first. Other strategies treat periodic processes
+ *  like any other process, but they still wait for their releases.
+ *
+ *  \param programID The program to execute.
+ *  \param period The period in milliseconds (at least 1).
+ *  \param deadline The deadline relative to each release in milliseconds
+ *                  (0 for the end of the period).
+ *  \return The new process or INVALID_PROCESS on failure.
+ */
+ProcessID os_execPeriodic(ProgramID programID, uint16_t period, uint16_t deadline) {
+	if (period == 0) {
+		return INVALID_PROCESS;
+	}
+	os_enterCriticalSection();
+	ProcessID pid = os_exec(programID, DEFAULT_PRIORITY);
+	if (pid != INVALID_PROCESS) {
+		os_procPeriod[pid] = os_msToSystemTime(period);
+		os_procRelativeDeadline[pid] = os_msToSystemTime(deadline ? deadline : period);
+		os_procRelease[pid] = getSystemTime();
+		os_procDeadline[pid] = os_procRelease[pid] + os_procRelativeDeadline[pid];
+		os_procDeadlineMisses[pid] = 0;
+		os_periodicMask |= PROCESS_BIT(pid);
+	}
+	os_leaveCriticalSection();
+	return pid;
+}
+
+/*!
+ *  Ends the current job of a periodic process and blocks it until the release
+ *  of its next job. If the job completed after its deadline, the deadline miss
+ *  counter of the process is incremented. A job that is late by more than a
+ *  period does not skip releases, the following jobs are released at once
+ *  until the process caught up. For other processes this is just os_yield.
+ */
+void os_waitForNextPeriod(void) {
+	ProcessID const pid = currentProc;
+	if (!(os_periodicMask & PROCESS_BIT(pid))) {
+		os_yield();
+		return;
+	}
+	
+	os_enterCriticalSection();
+	Time const now = getSystemTime();
+	if ((int32_t)(now - os_procDeadline[pid]) > 0) {
+		os_procDeadlineMisses[pid]++;
+	}
+	os_procRelease[pid] += os_procPeriod[pid];
+	os_procDeadline[pid] = os_procRelease[pid] + os_procRelativeDeadline[pid];
+	if ((int32_t)(os_procRelease[pid] - now) > 0) {
+		os_sleepFor(now, os_procRelease[pid] - now);
+	}
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  \param pid The periodic process.
+ *  \return The number of its jobs that completed after their deadline.
+ */
+uint16_t os_getDeadlineMisses(ProcessID pid) {
+	if (pid >= MAX_NUMBER_OF_PROCESSES) {
+		return 0;
+	}
+	os_enterCriticalSection();
+	uint16_t misses = os_procDeadlineMisses[pid];
+	os_leaveCriticalSection();
+	return misses;
+}
+
 /*!
  *  Used to register a function as program. On success the program is written to
  *  the first free slot within the os_programs array (if the program is not yet
@@ -157,12 +696,20 @@ bool os_checkAutostartProgram(ProgramID programID) {
 /*!
  *  This is the idle program. The idle process owns all the memory
  *  and processor time no other process wants to have.
+ *  With OS_TICKLESS_IDLE it sleeps until the next interrupt.
  */
 PROGRAM(0, AUTOSTART) {
+#if OS_TICKLESS_IDLE
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	while(true) {
+		sleep_mode();
+	}
+#else
     while(true) {
 		lcd_writeProgString(PSTR("."));
 		delayMs(DEFAULT_OUTPUT_DELAY);
 	}
+#endif
 }
 
 /*!
@@ -172,6 +719,10 @@ PROGRAM(0, AUTOSTART) {
  * \return The pointer to the according function, or NULL if programID is invalid.
  */
 Program* os_lookupProgramFunction(ProgramID programID) {
+    if (programID == TASKMAN_PROGRAM) {
+        return &os_taskManProgram;
+    }
+    
     // Return NULL if the index is out of range
     if (programID >= MAX_NUMBER_OF_PROGRAMS) {
         return NULL;
@@ -218,12 +769,61 @@ ProgramID os_lookupProgramID(Program* program) {
  *          INVALID_PROCESS as specified in defines.h).
  */
 ProcessID os_exec(ProgramID programID, Priority priority) {
+	return os_execWithStack(programID, priority, STACK_SIZE_PROC);
+}
+
+/*!
+ *  Finds a free part of the process stack region that is large enough for a
+ *  stack of the given size (first fit, starting at the highest address).
+ *  The region of a process is free again as soon as the process is killed.
+ *
+ *  \param size The requested stack size.
+ *  \return The bottom (highest address) of the stack or 0 if there is no room left.
+ */
+static uint16_t os_allocateStack(uint16_t size) {
+	uint16_t bottom = BOTTOM_OF_PROCS_STACK;
+	bool moved;
+	do {
+		if (bottom + 1 < TOP_OF_PROCS_STACK + size) {
+			return 0;
+		}
+		moved = false;
+		for (ProcessID pid = 0; pid < MAX_NUMBER_OF_PROCESSES; pid++) {
+			if (os_processes[pid].state == OS_PS_UNUSED) continue;
+			uint16_t otherBottom = os_procStackBottom[pid].as_int;
+			uint16_t otherTop = otherBottom - os_procStackSize[pid] + 1;
+			if (otherTop <= bottom && bottom - size + 1 <= otherBottom) {
+				// Overlapping, continue right above the other stack
+				bottom = otherTop - 1;
+				moved = true;
+			}
+		}
+	} while (moved);
+	return bottom;
+}
+
+/*!
+ *  Like os_exec, but the new process gets a stack of the given size instead
+ *  of STACK_SIZE_PROC. The stack is taken from the process stack region, so
+ *  processes with small stacks leave room for more or bigger ones. The region
+ *  has a fixed size, so space that no stack uses is only available to later
+ *  processes and is never handed to the internal heap at runtime.
+ *
+ *  \param programID The program id of the program to start (index of os_programs).
+ *  \param priority A priority ranging 0..255 for the new process.
+ *  \param stackSize The size of the stack in bytes (at least STACK_SIZE_PROC_MIN).
+ *  \return The index of the new process or INVALID_PROCESS on failure.
+ */
+ProcessID os_execWithStack(ProgramID programID, Priority priority, uint16_t stackSize) {
+	if (stackSize < STACK_SIZE_PROC_MIN) {
+		return INVALID_PROCESS;
+	}
 	os_enterCriticalSection();
     ProcessID index;
 	for(index = 0; index < MAX_NUMBER_OF_PROCESSES; index++) {
 		if(os_processes[index].state == OS_PS_UNUSED) break;
 	}
-	if(index >= MAX_NUMBER_OF_PROGRAMS) {
+	if(index >= MAX_NUMBER_OF_PROCESSES) {
 		os_leaveCriticalSection();	
 		return INVALID_PROCESS;
 	}
@@ -235,14 +835,29 @@ ProcessID os_exec(ProgramID programID, Priority priority) {
 	}
 	prog = &os_dispatcher;
 	
+	uint16_t stackBottom = os_allocateStack(stackSize);
+	if(stackBottom == 0) {
+		os_leaveCriticalSection();	
+		return INVALID_PROCESS;
+	}
+	
+	os_procStackBottom[index].as_int = stackBottom;
+	os_procStackSize[index] = stackSize;
 	os_processes[index].state = OS_PS_READY;
 	os_processes[index].progID = programID;
-	os_processes[index].priority = priority;
+	os_setProcessPriority(index, priority);
+	os_procCriticalSections[index] = 0;
+	os_procPreemptionCount[index] = 0;
+	os_procYielded[index] = false;
+	os_procCpuTime[index] = 0;
+	os_procSwitches[index] = 0;
+	os_periodicMask &= ~PROCESS_BIT(index);
+	os_readyMask |= PROCESS_BIT(index);
 
 	os_resetProcessSchedulingInformation(index);
 	
 	StackPointer proccess_stack_bottom;
-	proccess_stack_bottom.as_int = PROCESS_STACK_BOTTOM(index);
+	proccess_stack_bottom.as_int = stackBottom;
 	*(proccess_stack_bottom.as_ptr) = (uint8_t)(((uint16_t) prog << 8 ) >> 8);
 	proccess_stack_bottom.as_int--;
 	*(proccess_stack_bottom.as_ptr) = (uint8_t)((uint16_t) prog >> 8);
@@ -253,6 +868,9 @@ ProcessID os_exec(ProgramID programID, Priority priority) {
 	}
 	os_processes[index].sp.as_int = proccess_stack_bottom.as_int;
 	os_processes[index].checksum = os_getStackChecksum(index);
+#if STACK_CHECK_MODE == STACK_CHECK_CANARY
+	*(uint16_t*)(os_procStackBottom[index].as_int - stackSize + 1) = STACK_CANARY;
+#endif
 
 	os_leaveCriticalSection();
 
@@ -267,6 +885,10 @@ ProcessID os_exec(ProgramID programID, Priority priority) {
 void os_startScheduler(void) {
     currentProc = 0;
 	os_processes[0].state = OS_PS_RUNNING;
+	os_resetAccounting();
+#ifdef OS_FIXED_SCHEDULING_STRATEGY
+	os_resetSchedulingInformation(currentSchedStrat);
+#endif
 	SP = os_processes[0].sp.as_int;
 	restoreContext();
 }
@@ -279,6 +901,14 @@ void os_initScheduler(void) {
     for(uint8_t index = 0; index < MAX_NUMBER_OF_PROCESSES; index++) {
 		os_processes[index].state = OS_PS_UNUSED;
 	}
+	os_readyMask = 0;
+	os_sleepHead = INVALID_PROCESS;
+	
+	// Enter (PC0) and ESC (PC7) raise a pin change interrupt for the task manager hot key
+	sbi(PCMSK2, PCINT16);
+	sbi(PCMSK2, PCINT23);
+	sbi(PCICR, PCIE2);
+	os_initSchedulingInformation();
 	
 	for(uint8_t index = 0; index < MAX_NUMBER_OF_PROGRAMS; index++) {
 		if(os_checkAutostartProgram(index)) os_exec(index, DEFAULT_PRIORITY);
@@ -295,6 +925,20 @@ Process* os_getProcessSlot(ProcessID pid) {
     return os_processes + pid;
 }
 
+/*!
+ *  Sets the priority of a process. The strategies read the copy in
+ *  os_procPriority, which is updated here as well. A process that writes its
+ *  own priority to its slot directly is noticed with the next switch. While
+ *  the process inherits a higher priority through a mutex, it keeps that one
+ *  until the mutex is released.
+ *
+ *  \param pid The process to set the priority of.
+ *  \param priority The new priority.
+ */
+void os_setProcessPriority(ProcessID pid, Priority priority) {
+    os_syncSetBasePriority(pid, priority);
+}
+
 /*!
  *  A simple getter for the slot of a specific program.
  *
@@ -330,6 +974,96 @@ uint8_t os_getNumberOfActiveProcs(void) {
     return num;
 }
 
+/*!
+ *  Returns the processor time a process used since it was started or since
+ *  the accounting was reset, including its currently running time slice.
+ *
+ *  \param pid The process to return the time of.
+ *  \return The processor time in system time units (see getSystemTime).
+ */
+Time os_getProcessCpuTime(ProcessID pid) {
+    os_enterCriticalSection();
+    Time time = os_procCpuTime[pid];
+    if (pid == currentProc) {
+        time += getSystemTime() - os_lastSwitch;
+    }
+    os_leaveCriticalSection();
+    return time;
+}
+
+/*!
+ *  Returns how often the scheduler switched to a process since it was
+ *  started or since the accounting was reset.
+ *
+ *  \param pid The process to return the number of switches of.
+ *  \return The number of switches to the process.
+ */
+uint16_t os_getProcessSwitches(ProcessID pid) {
+    return os_procSwitches[pid];
+}
+
+/*!
+ *  Returns the processor time spent in scheduling decisions since the
+ *  accounting was reset. Saving and restoring the context is not included.
+ *
+ *  \return The processor time in system time units (see getSystemTime).
+ */
+Time os_getSchedulerTime(void) {
+    return os_schedulerTime;
+}
+
+/*!
+ *  Returns the time that passed since the accounting was reset, i.e. the sum
+ *  of the times of all processes and the scheduler.
+ *
+ *  \return The time in system time units (see getSystemTime).
+ */
+Time os_getAccountingTime(void) {
+    return getSystemTime() - os_accountingStart;
+}
+
+/*!
+ *  Resets the processor times and switch counts of all processes and the
+ *  scheduler.
+ */
+void os_resetAccounting(void) {
+    os_enterCriticalSection();
+    for (ProcessID pid = 0; pid < MAX_NUMBER_OF_PROCESSES; pid++) {
+        os_procCpuTime[pid] = 0;
+        os_procSwitches[pid] = 0;
+    }
+    os_schedulerTime = 0;
+#if OS_CYCLE_PROBE
+    for (uint8_t probe = 0; probe < OS_PROBE_COUNT; probe++) {
+        os_probeCycles[probe] = 0;
+    }
+    os_probeSamples = 0;
+#endif
+    os_lastSwitch = os_accountingStart = getSystemTime();
+    os_leaveCriticalSection();
+}
+
+/*!
+ *  Returns how many cycles a measured part of the context switch took on
+ *  average since the accounting was reset. The reading of the counter itself
+ *  adds a few cycles. Always 0 unless OS_CYCLE_PROBE is set.
+ *
+ *  \param probe The measured part of the switch.
+ *  \return The average number of cycles per context switch.
+ */
+uint16_t os_getProbeCycles(CycleProbe probe) {
+#if OS_CYCLE_PROBE
+    os_enterCriticalSection();
+    uint32_t const cycles = os_probeCycles[probe];
+    uint16_t const samples = os_probeSamples;
+    os_leaveCriticalSection();
+    return samples ? (uint16_t)(cycles / samples) : 0;
+#else
+    (void)probe;
+    return 0;
+#endif
+}
+
 /*!
  *  This function returns the number of currently registered programs.
  *
@@ -343,13 +1077,61 @@ uint8_t os_getNumberOfRegisteredPrograms(void) {
 }
 
 /*!
- *  Sets the current scheduling strategy.
+ *  Sets the current scheduling strategy. Has no effect if the strategy is
+ *  fixed by OS_FIXED_SCHEDULING_STRATEGY. The reset and the switch happen in
+ *  one critical section, so no tick sees a partly reset strategy.
  *
  *  \param strategy The strategy that will be used after the function finishes.
  */
 void os_setSchedulingStrategy(SchedulingStrategy strategy) {
+#ifndef OS_FIXED_SCHEDULING_STRATEGY
+	os_enterCriticalSection();
 	os_resetSchedulingInformation(strategy);
-    currentSchedStrat = strategy;
+	currentSchedStrat = strategy;
+	os_leaveCriticalSection();
+#endif
+}
+
+/*!
+ *  Sets the length of a scheduler tick, i.e. the period of timer 2. The
+ *  period is a multiple of TC2_PRESCALER / F_CPU (51.2 us), so it is rounded
+ *  to the nearest possible value between 102.4 us and 13.1 ms. Longer ticks
+ *  lower the scheduling overhead, shorter ticks lower the latency.
+ *  May be called while the scheduler is running, the current tick is cut
+ *  short if it already exceeds the new period.
+ *
+ *  \param us The new tick period in microseconds.
+ */
+void os_setTickPeriod(uint16_t us) {
+	uint32_t counts = ((uint32_t)us * (F_CPU / 1000000ul) + TC2_PRESCALER / 2) / TC2_PRESCALER;
+	if (counts < 2) {
+		counts = 2;
+	} else if (counts > 0x100) {
+		counts = 0x100;
+	}
+	
+	os_enterCriticalSection();
+	os_tickCompare = counts - 1;
+#if OS_TICKLESS_IDLE
+	// The stretched tick of idle is adjusted with the next scheduling decision
+	if (currentProc != 0)
+#endif
+	{
+		OCR2A = os_tickCompare;
+		if (TCNT2 >= os_tickCompare) {
+			TCNT2 = 0;
+		}
+	}
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Returns the length of a scheduler tick.
+ *
+ *  \return The tick period in microseconds.
+ */
+uint16_t os_getTickPeriod(void) {
+	return ((uint32_t)os_tickCompare + 1) * TC2_PRESCALER / (F_CPU / 1000000ul);
 }
 
 /*!
@@ -410,8 +1192,60 @@ void os_leaveCriticalSection(void) {
     }
 }
 
+/*!
+ *  Prevents the scheduler from switching to another process until
+ *  os_enablePreemption was called as often as this function. In contrast to
+ *  os_enterCriticalSection, neither SREG nor the scheduler interrupt are
+ *  touched, a tick that occurs meanwhile is merely deferred. So this is much
+ *  cheaper, but it only protects against other processes, not against
+ *  interrupt service routines. The process may still give up the processor
+ *  on its own (e.g. by os_yield). Supports up to 255 nested calls.
+ */
+void os_disablePreemption(void) {
+	preemptionCount++;
+}
+
+/*!
+ *  Counterpart of os_disablePreemption. If a tick was deferred meanwhile, the
+ *  outermost call hands over the processor at once.
+ */
+void os_enablePreemption(void) {
+	if (preemptionCount == 0) {
+		os_error("Tried to enable preemption without disabling it");
+		return;
+	}
+	if (--preemptionCount == 0 && preemptionPending) {
+		os_yield();
+	}
+}
+
+/*!
+ *  Returns the longest time the scheduler had to wait because preemption was
+ *  disabled, i.e. the worst additional latency caused by os_disablePreemption.
+ *
+ *  \return The time in system time units (see getSystemTime).
+ */
+Time os_getMaxPreemptionHoldOff(void) {
+	os_enterCriticalSection();
+	Time holdOff = preemptionMaxHoldOff;
+	os_leaveCriticalSection();
+	return holdOff;
+}
+
+/*!
+ *  Resets the longest time the scheduler had to wait because preemption was
+ *  disabled.
+ */
+void os_resetMaxPreemptionHoldOff(void) {
+	os_enterCriticalSection();
+	preemptionMaxHoldOff = 0;
+	os_leaveCriticalSection();
+}
+
 /*!
  *  Calculates the checksum of the stack for a certain process.
+ *  With STACK_CHECK_WINDOW only the STACK_CHECK_WINDOW_SIZE bytes next to the
+ *  saved stack pointer are taken into account.
  *
  *  \param pid The ID of the process for which the stack's checksum has to be calculated.
  *  \return The checksum of the pid'th stack.
@@ -419,8 +1253,25 @@ void os_leaveCriticalSection(void) {
 StackChecksum os_getStackChecksum(ProcessID pid) {
     StackChecksum sum = 0;
     StackPointer i;
-    for (i.as_int = PROCESS_STACK_BOTTOM(pid); i.as_int > os_processes[pid].sp.as_int; i.as_int--) {
+    uint16_t end = os_procStackBottom[pid].as_int;
+#if STACK_CHECK_MODE == STACK_CHECK_WINDOW
+    if (end - os_processes[pid].sp.as_int > STACK_CHECK_WINDOW_SIZE) {
+	    end = os_processes[pid].sp.as_int + STACK_CHECK_WINDOW_SIZE;
+    }
+#endif
+    for (i.as_int = end; i.as_int > os_processes[pid].sp.as_int; i.as_int--) {
 	    sum ^= *(i.as_ptr);
     }
     return sum;
+}
+
+/*!
+ *  Checks whether the canary word at the top of the stack of a certain
+ *  process is still intact, i.e. whether the stack did not overflow.
+ *
+ *  \param pid The ID of the process whose stack is to be checked.
+ *  \return True if the canary is intact.
+ */
+bool os_isStackCanaryIntact(ProcessID pid) {
+    return *(uint16_t*)(os_procStackBottom[pid].as_int - os_procStackSize[pid] + 1) == STACK_CANARY;
 }
\ No newline at end of file
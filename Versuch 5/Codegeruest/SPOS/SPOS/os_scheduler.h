@@ -26,11 +26,70 @@ typedef enum SchedulingStrategy {
     OS_SS_RANDOM,
     OS_SS_RUN_TO_COMPLETION,
     OS_SS_ROUND_ROBIN,
-    OS_SS_INACTIVE_AGING
+    OS_SS_INACTIVE_AGING,
+    OS_SS_MULTI_LEVEL_FEEDBACK_QUEUE,
+    OS_SS_STRIDE,
+    OS_SS_EARLIEST_DEADLINE_FIRST
 } SchedulingStrategy;
 
 // Change this define to reflect the number of available strategies:
-#define SCHEDULING_STRATEGY_COUNT 5
+#define SCHEDULING_STRATEGY_COUNT 8
+
+//! Maximum number of strategies, including the ones registered at runtime
+#define SCHEDULING_STRATEGY_MAX (SCHEDULING_STRATEGY_COUNT + OS_CUSTOM_STRATEGY_COUNT)
+
+//! Number to specify an invalid scheduling strategy
+#define INVALID_SCHEDULING_STRATEGY 255
+
+//! The parts of a context switch that are measured if OS_CYCLE_PROBE is set
+typedef enum CycleProbe {
+    OS_PROBE_STACK_CHECK,
+    OS_PROBE_SELECT,
+    OS_PROBE_COUNT
+} CycleProbe;
+
+//! Chooses the next process, see os_Scheduler_Even for the parameters
+typedef ProcessID SchedulingSelect(Process const processes[], ProcessID current);
+
+//! Resets the data of a strategy when it becomes the active strategy
+typedef void SchedulingReset(void);
+
+//! Resets the data of a strategy for a process that is started
+typedef void SchedulingProcessReset(ProcessID pid);
+
+/*!
+ *  Describes a scheduling strategy. The hooks are called while the scheduler
+ *  cannot run, i.e. from the scheduler interrupt or within a critical
+ *  section, the reset hooks may be NULL. The name is a string in program
+ *  memory that is shown by the task manager, padded with spaces to 23
+ *  characters (like "<Even>                 ").
+ */
+typedef struct SchedulingStrategyDescriptor {
+    SchedulingSelect* select;
+    SchedulingReset* reset;
+    SchedulingProcessReset* resetProcess;
+    char const* name;
+} SchedulingStrategyDescriptor;
+
+//----------------------------------------------------------------------------
+// Globals
+//----------------------------------------------------------------------------
+
+/*!
+ *  Set of all processes that may be selected by a scheduling strategy, i.e.
+ *  all processes that are ready or running. It is updated on every state
+ *  transition, so the strategies never have to scan os_processes for it.
+ */
+extern ProcessMask os_readyMask;
+
+//! Set of processes that were started by os_execPeriodic
+extern ProcessMask os_periodicMask;
+
+//! Absolute deadline of the current job of every periodic process
+extern Time os_procDeadline[MAX_NUMBER_OF_PROCESSES];
+
+//! Priority of every process as seen by the strategies (see os_setProcessPriority)
+extern Priority os_procPriority[MAX_NUMBER_OF_PROCESSES];
 
 //----------------------------------------------------------------------------
 // Function headers
@@ -39,6 +98,9 @@ typedef enum SchedulingStrategy {
 //! Get a pointer to the process structure by process ID
 Process* os_getProcessSlot(ProcessID pid);
 
+//! Sets the priority of a process
+void os_setProcessPriority(ProcessID pid, Priority priority);
+
 //! Starts the scheduler
 void os_startScheduler(void);
 
@@ -46,6 +108,24 @@ void os_dispatcher(void);
 
 bool os_kill(ProcessID pid);
 
+//! Starts the task manager process
+void os_startTaskMan(void);
+
+//! Gives up the processor for the rest of the current time slice
+void os_yield(void);
+
+//! Blocks the current process for the given number of milliseconds
+void os_sleep(uint16_t ms);
+
+//! Executes a process whose jobs are released periodically (times in milliseconds)
+ProcessID os_execPeriodic(ProgramID programID, uint16_t period, uint16_t deadline);
+
+//! Ends the current job of a periodic process and waits for the next release
+void os_waitForNextPeriod(void);
+
+//! Returns the number of jobs of a periodic process that missed their deadline
+uint16_t os_getDeadlineMisses(ProcessID pid);
+
 //! Registers a program (will not be started)
 ProgramID os_registerProgram(Program* program);
 
@@ -61,6 +141,9 @@ ProgramID os_lookupProgramID(Program* program);
 //! Executes a process by instantiating a program
 ProcessID os_exec(ProgramID programID, Priority priority);
 
+//! Executes a process with a stack of the given size
+ProcessID os_execWithStack(ProgramID programID, Priority priority, uint16_t stackSize);
+
 //! Returns the number of programs
 uint8_t os_getNumberOfRegisteredPrograms(void);
 
@@ -73,15 +156,51 @@ ProcessID os_getCurrentProc(void);
 //! Returns the number of currently active processes
 uint8_t os_getNumberOfActiveProcs(void);
 
+//! Returns the processor time used by the process with pid (in system time units)
+Time os_getProcessCpuTime(ProcessID pid);
+
+//! Returns how often the process with pid was switched to
+uint16_t os_getProcessSwitches(ProcessID pid);
+
+//! Returns the processor time spent in the scheduler (in system time units)
+Time os_getSchedulerTime(void);
+
+//! Returns the time that passed since the accounting was reset (in system time units)
+Time os_getAccountingTime(void);
+
+//! Resets the processor time accounting of all processes and the scheduler
+void os_resetAccounting(void);
+
+//! Returns the average number of cycles a measured part of the switch took
+uint16_t os_getProbeCycles(CycleProbe probe);
+
 //! Sets the scheduling strategy
 void os_setSchedulingStrategy(SchedulingStrategy strategy);
 
 //! Gets the current scheduling strategy
 SchedulingStrategy os_getSchedulingStrategy(void);
 
+//! Adds a scheduling strategy and returns its ID (INVALID_SCHEDULING_STRATEGY if there is no free slot)
+SchedulingStrategy os_registerSchedulingStrategy(SchedulingStrategyDescriptor const* descriptor);
+
+//! Returns the descriptor of a scheduling strategy or NULL if there is none with that ID
+SchedulingStrategyDescriptor const* os_getSchedulingStrategyDescriptor(SchedulingStrategy strategy);
+
+//! Returns the number of available scheduling strategies (built-in and registered)
+uint8_t os_getNumberOfSchedulingStrategies(void);
+
+//! Sets the length of a scheduler tick in microseconds
+void os_setTickPeriod(uint16_t us);
+
+//! Returns the length of a scheduler tick in microseconds
+uint16_t os_getTickPeriod(void);
+
 //! Calculates the checksum of the stack for the corresponding process of pid.
 StackChecksum os_getStackChecksum(ProcessID pid);
 
+//! Checks the canary word at the top of the stack of the process with pid.
+bool os_isStackCanaryIntact(ProcessID pid);
+
 //----------------------------------------------------------------------------
 // Critical section management
 //----------------------------------------------------------------------------
@@ -92,4 +211,16 @@ void os_enterCriticalSection(void);
 //! Leaves a critical code section
 void os_leaveCriticalSection(void);
 
+//! Prevents the scheduler from switching to another process
+void os_disablePreemption(void);
+
+//! Allows the scheduler to switch to another process again
+void os_enablePreemption(void);
+
+//! Returns the longest time a scheduler tick was deferred by os_disablePreemption
+Time os_getMaxPreemptionHoldOff(void);
+
+//! Resets the longest time a scheduler tick was deferred
+void os_resetMaxPreemptionHoldOff(void);
+
 #endif
@@ -2,35 +2,342 @@
 #include "defines.h"
 
 #include <stdlib.h>
+#include <avr/pgmspace.h>
 
 SchedulingInformation schedulingInfo;
 
+//! Index of the lowest set bit of every nibble (the entry for 0 is never used)
+static uint8_t const lowestBitOfNibble[16] PROGMEM = {
+	0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+};
+
+//! Number of set bits of every nibble
+static uint8_t const bitsOfNibble[16] PROGMEM = {
+	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+};
+
+/*!
+ *  Finds the process with the lowest ID in a set of processes.
+ *
+ *  \param mask A non-empty set of processes.
+ *  \return The lowest ProcessID contained in mask.
+ */
+static ProcessID lowestProcess(ProcessMask mask) {
+	ProcessID pid = 0;
+#if MAX_NUMBER_OF_PROCESSES > 8
+	while (!(mask & 0xFF)) {
+		mask >>= 8;
+		pid += 8;
+	}
+#endif
+	while (!(mask & 0xF)) {
+		mask >>= 4;
+		pid += 4;
+	}
+	return pid + pgm_read_byte(&lowestBitOfNibble[mask & 0xF]);
+}
+
+/*!
+ *  Counts the processes in a set of processes.
+ *
+ *  \param mask The set of processes.
+ *  \return The number of processes contained in mask.
+ */
+static uint8_t countProcesses(ProcessMask mask) {
+	uint8_t count = 0;
+	for (; mask; mask >>= 4) {
+		count += pgm_read_byte(&bitsOfNibble[mask & 0xF]);
+	}
+	return count;
+}
+
+/*!
+ *  Finds the ready process that follows current in cyclic order of the
+ *  ProcessIDs. The idle process is never returned unless nothing else is ready.
+ *
+ *  \param current The process to start searching after.
+ *  \return The next ready process after current (possibly current itself) or 0.
+ */
+static ProcessID nextReadyProcess(ProcessID current) {
+	ProcessMask ready = os_readyMask & ~PROCESS_BIT(0);
+	if (!ready) {
+		return 0;
+	}
+	ProcessMask following = ready & ~(PROCESS_BIT(current) | (PROCESS_BIT(current) - 1));
+	return lowestProcess(following ? following : ready);
+}
+
+static void os_resetRoundRobin(void);
+static void os_resetInactiveAging(void);
+static void os_resetInactiveAgingProcess(ProcessID id);
+static void os_resetMLFQ(void);
+static void os_resetMLFQProcess(ProcessID id);
+static void os_resetStride(void);
+static void os_resetStrideProcess(ProcessID id);
+
+static char const evenName[] PROGMEM            = "<Even>                 ";
+static char const randomName[] PROGMEM          = "<Random>               ";
+static char const runToCompletionName[] PROGMEM = "<Run To Completion>    ";
+static char const roundRobinName[] PROGMEM      = "<Round Robin>          ";
+static char const inactiveAgingName[] PROGMEM   = "<Inactive Aging>       ";
+static char const mlfqName[] PROGMEM            = "<MLFQ>                 ";
+static char const strideName[] PROGMEM          = "<Stride>               ";
+static char const edfName[] PROGMEM             = "<EDF>                  ";
+
+static SchedulingStrategyDescriptor const evenStrategy = {
+	os_Scheduler_Even, NULL, NULL, evenName
+};
+static SchedulingStrategyDescriptor const randomStrategy = {
+	os_Scheduler_Random, NULL, NULL, randomName
+};
+static SchedulingStrategyDescriptor const runToCompletionStrategy = {
+	os_Scheduler_RunToCompletion, NULL, NULL, runToCompletionName
+};
+static SchedulingStrategyDescriptor const roundRobinStrategy = {
+	os_Scheduler_RoundRobin, os_resetRoundRobin, NULL, roundRobinName
+};
+static SchedulingStrategyDescriptor const inactiveAgingStrategy = {
+	os_Scheduler_InactiveAging, os_resetInactiveAging, os_resetInactiveAgingProcess, inactiveAgingName
+};
+static SchedulingStrategyDescriptor const mlfqStrategy = {
+	os_Scheduler_MLFQ, os_resetMLFQ, os_resetMLFQProcess, mlfqName
+};
+static SchedulingStrategyDescriptor const strideStrategy = {
+	os_Scheduler_Stride, os_resetStride, os_resetStrideProcess, strideName
+};
+static SchedulingStrategyDescriptor const edfStrategy = {
+	os_Scheduler_EDF, NULL, NULL, edfName
+};
+
+#ifndef OS_FIXED_SCHEDULING_STRATEGY
+
+//! The descriptors of all available strategies, the built-in ones first
+SchedulingStrategyDescriptor const* os_schedulingStrategies[SCHEDULING_STRATEGY_MAX] = {
+	[OS_SS_EVEN] = &evenStrategy,
+	[OS_SS_RANDOM] = &randomStrategy,
+	[OS_SS_RUN_TO_COMPLETION] = &runToCompletionStrategy,
+	[OS_SS_ROUND_ROBIN] = &roundRobinStrategy,
+	[OS_SS_INACTIVE_AGING] = &inactiveAgingStrategy,
+	[OS_SS_MULTI_LEVEL_FEEDBACK_QUEUE] = &mlfqStrategy,
+	[OS_SS_STRIDE] = &strideStrategy,
+	[OS_SS_EARLIEST_DEADLINE_FIRST] = &edfStrategy
+};
+
+//! Number of used entries of os_schedulingStrategies
+uint8_t os_schedulingStrategyCount = SCHEDULING_STRATEGY_COUNT;
+
+#endif
+
 /*!
- *  Reset the scheduling information for a specific strategy
- *  This is only relevant for RoundRobin and InactiveAging
- *  and is done when the strategy is changed through os_setSchedulingStrategy
+ *  Initializes all ProcessQueues for the MLFQ and the quanta of all strategies.
+ */
+void os_initSchedulingInformation(void) {
+	for (uint8_t i = 0; i < MLFQ_QUEUE_COUNT; i++) {
+		pqueue_init(MLFQ_getQueue(i));
+	}
+	for (uint8_t i = 0; i < SCHEDULING_STRATEGY_MAX; i++) {
+		schedulingInfo.quantum[i] = 1;
+	}
+}
+
+/*!
+ *  Adds a scheduling strategy to the table of strategies, so it can be
+ *  activated with os_setSchedulingStrategy and selected in the task manager.
+ *  The descriptor is not copied and has to stay valid. Not available if the
+ *  strategy is fixed by OS_FIXED_SCHEDULING_STRATEGY.
+ *
+ *  \param descriptor The descriptor of the new strategy (the select hook is mandatory).
+ *  \return The ID of the new strategy or INVALID_SCHEDULING_STRATEGY if all
+ *          OS_CUSTOM_STRATEGY_COUNT slots are used.
+ */
+SchedulingStrategy os_registerSchedulingStrategy(SchedulingStrategyDescriptor const* descriptor) {
+#ifdef OS_FIXED_SCHEDULING_STRATEGY
+	return INVALID_SCHEDULING_STRATEGY;
+#else
+	if (descriptor->select == NULL) {
+		return INVALID_SCHEDULING_STRATEGY;
+	}
+	os_enterCriticalSection();
+	SchedulingStrategy strategy = INVALID_SCHEDULING_STRATEGY;
+	if (os_schedulingStrategyCount < SCHEDULING_STRATEGY_MAX) {
+		strategy = os_schedulingStrategyCount++;
+		os_schedulingStrategies[strategy] = descriptor;
+	}
+	os_leaveCriticalSection();
+	return strategy;
+#endif
+}
+
+/*!
+ *  \param strategy The ID of the strategy.
+ *  \return The descriptor of the strategy or NULL if there is none with that ID.
+ */
+SchedulingStrategyDescriptor const* os_getSchedulingStrategyDescriptor(SchedulingStrategy strategy) {
+#ifdef OS_FIXED_SCHEDULING_STRATEGY
+	// Only the fixed strategy is referenced, so the linker drops the others
+	if (strategy != (OS_FIXED_SCHEDULING_STRATEGY)) {
+		return NULL;
+	}
+	switch (OS_FIXED_SCHEDULING_STRATEGY) {
+		case OS_SS_EVEN: return &evenStrategy;
+		case OS_SS_RANDOM: return &randomStrategy;
+		case OS_SS_RUN_TO_COMPLETION: return &runToCompletionStrategy;
+		case OS_SS_ROUND_ROBIN: return &roundRobinStrategy;
+		case OS_SS_INACTIVE_AGING: return &inactiveAgingStrategy;
+		case OS_SS_MULTI_LEVEL_FEEDBACK_QUEUE: return &mlfqStrategy;
+		case OS_SS_STRIDE: return &strideStrategy;
+		case OS_SS_EARLIEST_DEADLINE_FIRST: return &edfStrategy;
+	}
+	return NULL;
+#else
+	return strategy < os_schedulingStrategyCount ? os_schedulingStrategies[strategy] : NULL;
+#endif
+}
+
+/*!
+ *  \return The number of strategies that may be passed to os_setSchedulingStrategy.
+ */
+uint8_t os_getNumberOfSchedulingStrategies(void) {
+#ifdef OS_FIXED_SCHEDULING_STRATEGY
+	return (OS_FIXED_SCHEDULING_STRATEGY) + 1;
+#else
+	return os_schedulingStrategyCount;
+#endif
+}
+
+/*!
+ *  Sets the quantum of a strategy, i.e. how many ticks one unit of a time
+ *  slice lasts. Round robin gives every process priority * quantum ticks and
+ *  the MLFQ gives its classes quantum, 2 * quantum, 4 * quantum and
+ *  8 * quantum ticks (at most 255). The other strategies decide on every tick
+ *  and ignore it. The new quantum applies to the next time slice that is
+ *  handed out, so it may be changed while the scheduler is running.
+ *
+ *  \param strategy The strategy to set the quantum of.
+ *  \param quantum The number of ticks per time slice unit (at least 1).
+ */
+void os_setStrategyQuantum(SchedulingStrategy strategy, uint8_t quantum) {
+	if (strategy < SCHEDULING_STRATEGY_MAX) {
+		schedulingInfo.quantum[strategy] = quantum ? quantum : 1;
+	}
+}
+
+/*!
+ *  Returns the quantum of a strategy (see os_setStrategyQuantum).
+ *
+ *  \param strategy The strategy to get the quantum of.
+ *  \return The number of ticks per time slice unit.
+ */
+uint8_t os_getStrategyQuantum(SchedulingStrategy strategy) {
+	return schedulingInfo.quantum[strategy];
+}
+
+/*!
+ *  Puts a process at the end of the queue of the given priority class and
+ *  hands it the full quantum of that class.
+ *
+ *  \param pid  The process to enqueue
+ *  \param queueID  The priority class of the process
+ */
+static void MLFQ_enqueue(ProcessID pid, uint8_t queueID) {
+	schedulingInfo.mlfqClass[pid] = queueID;
+	schedulingInfo.mlfqSlice[pid] = MLFQ_getDefaultTimeslice(queueID);
+	schedulingInfo.mlfqMembers[queueID] |= PROCESS_BIT(pid);
+	pqueue_append(MLFQ_getQueue(queueID), pid);
+}
+
+/*!
+ *  Reset the scheduling information for a specific strategy by calling its
+ *  reset hook. This is done when the strategy is changed through
+ *  os_setSchedulingStrategy.
  *
  * \param strategy  The strategy to reset information for
  */
 void os_resetSchedulingInformation(SchedulingStrategy strategy) {
-    if(strategy == OS_SS_ROUND_ROBIN) {
-		schedulingInfo.timeSlice = os_getProcessSlot(os_getCurrentProc())->priority;
-	}else if(strategy == OS_SS_INACTIVE_AGING) {
-		for(uint8_t i = 0; i < MAX_NUMBER_OF_PROCESSES; i++) {
-			schedulingInfo.age[i] = 0;
-		}
+	SchedulingStrategyDescriptor const* descriptor = os_getSchedulingStrategyDescriptor(strategy);
+	if (descriptor != NULL && descriptor->reset != NULL) {
+		descriptor->reset();
 	}
 }
 
 /*!
  *  Reset the scheduling information for a specific process slot
  *  This is necessary when a new process is started to clear out any
- *  leftover data from a process that previously occupied that slot
+ *  leftover data from a process that previously occupied that slot.
+ *  Only the active strategy is concerned, the others reset all their data
+ *  when they are activated.
  *
  *  \param id  The process slot to erase state for
  */
 void os_resetProcessSchedulingInformation(ProcessID id) {
-    schedulingInfo.age[id] = 0;
+	SchedulingStrategyDescriptor const* descriptor = os_getSchedulingStrategyDescriptor(os_getSchedulingStrategy());
+	if (descriptor != NULL && descriptor->resetProcess != NULL) {
+		descriptor->resetProcess(id);
+	}
+}
+
+/*!
+ *  Computes the round robin time slice of a process. Priority 0 counts as 1,
+ *  an empty slice would wrap around on its first decrement.
+ *
+ *  \param priority The priority of the process.
+ *  \return The number of ticks the process may run.
+ */
+static uint16_t RR_getTimeSlice(Priority priority) {
+	return (priority ? priority : 1) * schedulingInfo.quantum[OS_SS_ROUND_ROBIN];
+}
+
+/*!
+ *  Hands the current process a full time slice.
+ */
+static void os_resetRoundRobin(void) {
+	schedulingInfo.timeSlice = RR_getTimeSlice(os_procPriority[os_getCurrentProc()]);
+}
+
+/*!
+ *  Resets the age of all processes.
+ */
+static void os_resetInactiveAging(void) {
+	for(uint8_t i = 0; i < MAX_NUMBER_OF_PROCESSES; i++) {
+		schedulingInfo.age[i] = 0;
+	}
+}
+
+/*!
+ *  Resets the age of a started process.
+ *
+ *  \param id The started process.
+ */
+static void os_resetInactiveAgingProcess(ProcessID id) {
+	schedulingInfo.age[id] = 0;
+}
+
+/*!
+ *  Puts every process into the queue of the class derived from its priority.
+ */
+static void os_resetMLFQ(void) {
+	for(uint8_t i = 0; i < MLFQ_QUEUE_COUNT; i++) {
+		pqueue_reset(MLFQ_getQueue(i));
+		schedulingInfo.mlfqMembers[i] = 0;
+	}
+	// The idle process is not queued, it only runs if all queues are empty
+	for(ProcessID pid = 1; pid < MAX_NUMBER_OF_PROCESSES; pid++) {
+		if(os_getProcessSlot(pid)->state != OS_PS_UNUSED) {
+			MLFQ_enqueue(pid, MLFQ_MapToQueue(os_procPriority[pid]));
+		}
+	}
+}
+
+/*!
+ *  Puts a started process into the queue of the class derived from its priority.
+ *
+ *  \param id The started process.
+ */
+static void os_resetMLFQProcess(ProcessID id) {
+	MLFQ_removePID(id);
+	if (id != 0) {
+		MLFQ_enqueue(id, MLFQ_MapToQueue(os_procPriority[id]));
+	}
 }
 
 /*!
@@ -44,10 +351,7 @@ void os_resetProcessSchedulingInformation(ProcessID id) {
  *  \return The next process to be executed determined on the basis of the even strategy.
  */
 ProcessID os_Scheduler_Even(Process const processes[], ProcessID current) {
-    for(uint8_t i = current + 1; i <= MAX_NUMBER_OF_PROCESSES + current; i++) {
-		if(processes[i % MAX_NUMBER_OF_PROCESSES].state == OS_PS_READY && i % MAX_NUMBER_OF_PROCESSES != 0) return i % MAX_NUMBER_OF_PROCESSES;
-	}
-	return 0;
+	return nextReadyProcess(current);
 }
 
 /*!
@@ -59,16 +363,13 @@ ProcessID os_Scheduler_Even(Process const processes[], ProcessID current) {
  *  \return The next process to be executed determined on the basis of the random strategy.
  */
 ProcessID os_Scheduler_Random(Process const processes[], ProcessID current) {
-	uint8_t number_active_procs = os_getNumberOfActiveProcs();
-    if(number_active_procs == 1) return 0; //Only idle process
-    uint8_t active_found = 0;
-    uint8_t result = rand() % (number_active_procs - 1);
-	for(uint8_t i = 1; i < MAX_NUMBER_OF_PROCESSES; i++) {
-		if(processes[i].state == OS_PS_READY) {
-			if(active_found++ == result) return i;
-		}
+	ProcessMask ready = os_readyMask & ~PROCESS_BIT(0);
+	if(!ready) return 0; //Only idle process
+	uint8_t result = rand() % countProcesses(ready);
+	while(result--) {
+		ready &= ready - 1; // Drop the lowest process
 	}
-	return 0; // For the compiler
+	return lowestProcess(ready);
 }
 
 /*!
@@ -83,9 +384,9 @@ ProcessID os_Scheduler_Random(Process const processes[], ProcessID current) {
  *  \return The next process to be executed determined on the basis of the round robin strategy.
  */
 ProcessID os_Scheduler_RoundRobin(Process const processes[], ProcessID current) {
-    if(processes[current].state != OS_PS_READY || schedulingInfo.timeSlice == 1) {
+    if(!(os_readyMask & PROCESS_BIT(current)) || schedulingInfo.timeSlice == 1) {
 		ProcessID id = os_Scheduler_Even(processes, current);
-		schedulingInfo.timeSlice = processes[id].priority;
+		schedulingInfo.timeSlice = RR_getTimeSlice(os_procPriority[id]);
 		return id;
 	}
 	schedulingInfo.timeSlice -= 1;
@@ -104,27 +405,29 @@ ProcessID os_Scheduler_RoundRobin(Process const processes[], ProcessID current)
  *  \return The next process to be executed, determined based on the inactive-aging strategy.
  */
 ProcessID os_Scheduler_InactiveAging(Process const processes[], ProcessID current) {
+	ProcessMask const ready = os_readyMask & ~PROCESS_BIT(0);
+	ProcessMask mask;
+	ProcessID i;
+
 	// Update aged
-	uint8_t i;
-	for (i = 1; i < MAX_NUMBER_OF_PROCESSES; i++) {
-		if (processes[i].state == OS_PS_READY && i != current) {
-			schedulingInfo.age[i] += processes[i].priority;
-		}
+	for (mask = ready & ~PROCESS_BIT(current); mask; mask &= mask - 1) {
+		i = lowestProcess(mask);
+		schedulingInfo.age[i] += os_procPriority[i];
 	}
 	
 	// Select highest
-	uint8_t max_age = 0;
-	for (i = 1; i < MAX_NUMBER_OF_PROCESSES; i++) {
-		if (processes[i].state == OS_PS_READY && schedulingInfo.age[i] > schedulingInfo.age[max_age]) {
+	ProcessID max_age = 0;
+	for (mask = ready; mask; mask &= mask - 1) {
+		i = lowestProcess(mask);
+		if (schedulingInfo.age[i] > schedulingInfo.age[max_age]) {
 			max_age = i;
-		}
-		if (processes[i].state == OS_PS_READY && schedulingInfo.age[i] == schedulingInfo.age[max_age] && processes[i].priority > processes[max_age].priority) {
-			// if processes[i].priority == processes[max_age].priority then do nothing because we traverse array in correct order
+		} else if (schedulingInfo.age[i] == schedulingInfo.age[max_age] && os_procPriority[i] > os_procPriority[max_age]) {
+			// if both priorities are equal then do nothing because we traverse array in correct order
 			max_age = i;
 		}
 	}
 	
-	schedulingInfo.age[max_age] = processes[max_age].priority;
+	schedulingInfo.age[max_age] = os_procPriority[max_age];
 
 	return max_age;
 }
@@ -139,6 +442,312 @@ ProcessID os_Scheduler_InactiveAging(Process const processes[], ProcessID curren
  *  \return The next process to be executed, determined based on the run-to-completion strategy.
  */
 ProcessID os_Scheduler_RunToCompletion(Process const processes[], ProcessID current) {
-    if(processes[current].state == OS_PS_UNUSED) return os_Scheduler_Even(processes, current);
+    if(!(os_readyMask & PROCESS_BIT(current))) return os_Scheduler_Even(processes, current);
 	return current;
 }
+
+/*!
+ *  Moves the given process to the end of the next lower class (or of the
+ *  lowest class again) and gives it the full quantum of that class.
+ *
+ *  \param pid The process that used up its quantum.
+ */
+static void MLFQ_demote(ProcessID pid) {
+	uint8_t const queueID = schedulingInfo.mlfqClass[pid];
+	MLFQ_removePID(pid);
+	MLFQ_enqueue(pid, (queueID + 1 < MLFQ_QUEUE_COUNT) ? queueID + 1 : queueID);
+}
+
+/*!
+ *  Finds the first ready process of the highest class with a ready process.
+ *
+ *  \return The found process or 0 if no process is ready.
+ */
+static ProcessID MLFQ_firstReady(void) {
+	for (uint8_t queueID = 0; queueID < MLFQ_QUEUE_COUNT; queueID++) {
+		// Classes without a ready process are skipped without walking their queue
+		if (!(schedulingInfo.mlfqMembers[queueID] & os_readyMask)) {
+			continue;
+		}
+		ProcessQueue const* queue = MLFQ_getQueue(queueID);
+		for (uint8_t i = queue->head; i != queue->tail; i = (i + 1) % queue->size) {
+			ProcessID pid = queue->data[i];
+			if (os_readyMask & PROCESS_BIT(pid)) {
+				return pid;
+			}
+		}
+	}
+	return 0;
+}
+
+/*!
+ *  This function implements the multi-level-feedback-queue strategy. Every
+ *  process belongs to one of MLFQ_QUEUE_COUNT priority classes, initially
+ *  derived from its priority. Each class has a queue and a quantum. The first
+ *  ready process of the highest non-empty class is chosen and one unit of its
+ *  quantum is consumed. A process that has used up its whole quantum is moved
+ *  to the end of the next lower class. This also happens when such a process
+ *  is about to be chosen without being the current one (e.g. it blocked right
+ *  after its last unit), so a quantum is never consumed below zero. A process
+ *  that gave up the processor before its quantum was used up (e.g. by
+ *  yielding) stays in its class, but is moved to the end of its queue. Thus
+ *  interactive processes keep their high class while CPU-bound ones sink to
+ *  the classes with longer quanta.
+ *
+ *  \param processes An array holding the processes to choose the next process from.
+ *  \param current The id of the current process.
+ *  \return The next process to be executed, determined based on the MLFQ strategy.
+ */
+ProcessID os_Scheduler_MLFQ(Process const processes[], ProcessID current) {
+	if (current != 0 && processes[current].state != OS_PS_UNUSED) {
+		uint8_t queueID = schedulingInfo.mlfqClass[current];
+		if (schedulingInfo.mlfqSlice[current] == 0) {
+			MLFQ_demote(current);
+		} else if (!(os_readyMask & PROCESS_BIT(current))) {
+			MLFQ_removePID(current);
+			schedulingInfo.mlfqMembers[queueID] |= PROCESS_BIT(current);
+			pqueue_append(MLFQ_getQueue(queueID), current);
+		}
+	}
+
+	ProcessID pid = MLFQ_firstReady();
+	// A demoted process gets a quantum of at least one, so this ends
+	while (pid != 0 && schedulingInfo.mlfqSlice[pid] == 0) {
+		MLFQ_demote(pid);
+		pid = MLFQ_firstReady();
+	}
+	if (pid != 0) {
+		schedulingInfo.mlfqSlice[pid]--;
+	}
+	return pid;
+}
+
+/*!
+ *  Resets the virtual time of all processes, so all of them start on equal
+ *  terms. The strides are recomputed on their next use.
+ */
+static void os_resetStride(void) {
+	for (ProcessID pid = 0; pid < MAX_NUMBER_OF_PROCESSES; pid++) {
+		schedulingInfo.stridePass[pid] = 0;
+		schedulingInfo.stride[pid] = STRIDE_ONE;
+		schedulingInfo.stridePriority[pid] = 0;
+	}
+	schedulingInfo.strideGlobalPass = 0;
+	schedulingInfo.strideReady = 0;
+}
+
+/*!
+ *  Lets a started process join at the current virtual time, so it neither
+ *  gets credit for the time before its start nor has to catch up.
+ *
+ *  \param id The started process.
+ */
+static void os_resetStrideProcess(ProcessID id) {
+	schedulingInfo.stridePass[id] = 0;
+	schedulingInfo.strideReady &= ~PROCESS_BIT(id);
+}
+
+/*!
+ *  This function implements the stride strategy. Every process has a virtual
+ *  time (its pass) that advances by its stride, which is inversely
+ *  proportional to its priority, whenever it is chosen. The ready process
+ *  with the lowest pass is chosen, ties are broken by the lower ProcessID.
+ *  Thus, in every interval the number of time slices of the ready processes
+ *  is proportional to their priorities (up to one slice), deterministically.
+ *  Priorities 0 and 1 both get the largest stride.
+ *  The passes are 16 bit values that wrap around, so they are only compared
+ *  by their difference. When a process stops being ready, only the distance
+ *  of its pass to the virtual time is kept (its remaining credit), and when
+ *  it is ready again its pass continues at that distance from the then
+ *  current virtual time. Thus a blocked process neither gains nor loses
+ *  credit while it is blocked, and every ready pass stays within one stride
+ *  (STRIDE_ONE) above the virtual time, so the differences cannot overflow.
+ *  Only the ready processes and those whose state changed since the last
+ *  selection are visited, and no division is needed unless the priority of
+ *  the chosen process changed.
+ *
+ *  \param processes An array holding the processes to choose the next process from.
+ *  \param current The id of the current process.
+ *  \return The next process to be executed, determined based on the stride strategy.
+ */
+ProcessID os_Scheduler_Stride(Process const processes[], ProcessID current) {
+	ProcessMask mask = os_readyMask & ~PROCESS_BIT(0);
+	uint16_t const globalPass = schedulingInfo.strideGlobalPass;
+	for (ProcessMask changed = mask ^ schedulingInfo.strideReady; changed; changed &= changed - 1) {
+		ProcessID i = lowestProcess(changed);
+		if (mask & PROCESS_BIT(i)) {
+			schedulingInfo.stridePass[i] += globalPass; // Credit back to a pass
+		} else {
+			schedulingInfo.stridePass[i] -= globalPass; // Pass to its remaining credit
+		}
+	}
+	schedulingInfo.strideReady = mask;
+	if (!mask) {
+		return 0;
+	}
+	
+	ProcessID next = lowestProcess(mask);
+	for (; mask; mask &= mask - 1) {
+		ProcessID i = lowestProcess(mask);
+		if ((int16_t)(schedulingInfo.stridePass[i] - schedulingInfo.stridePass[next]) < 0) {
+			next = i;
+		}
+	}
+	
+	Priority const priority = os_procPriority[next];
+	if (schedulingInfo.stridePriority[next] != priority) {
+		schedulingInfo.stridePriority[next] = priority;
+		schedulingInfo.stride[next] = STRIDE_ONE / (priority ? priority : 1);
+	}
+	schedulingInfo.strideGlobalPass = schedulingInfo.stridePass[next];
+	schedulingInfo.stridePass[next] += schedulingInfo.stride[next];
+	return next;
+}
+
+/*!
+ *  This function implements the earliest-deadline-first strategy. The ready
+ *  periodic process (see os_execPeriodic) whose current job has the nearest
+ *  absolute deadline is chosen, ties are broken by the lower ProcessID.
+ *  Periodic processes are only ready between the release of a job and its
+ *  os_waitForNextPeriod. The other processes run in the background with the
+ *  even strategy while no periodic process is ready.
+ *
+ *  \param processes An array holding the processes to choose the next process from.
+ *  \param current The id of the current process.
+ *  \return The next process to be executed, determined based on the EDF strategy.
+ */
+ProcessID os_Scheduler_EDF(Process const processes[], ProcessID current) {
+	ProcessMask mask = os_readyMask & os_periodicMask;
+	if (!mask) {
+		return nextReadyProcess(current);
+	}
+	
+	ProcessID next = lowestProcess(mask);
+	for (mask &= mask - 1; mask; mask &= mask - 1) {
+		ProcessID i = lowestProcess(mask);
+		if ((int32_t)(os_procDeadline[i] - os_procDeadline[next]) < 0) {
+			next = i;
+		}
+	}
+	return next;
+}
+
+/*!
+ *  Removes the given ProcessID from its ProcessQueue, keeping the order of
+ *  the remaining processes. Only the queue of its class is touched, and none
+ *  if the process is not queued.
+ *
+ *  \param pid The ProcessID to remove.
+ */
+void MLFQ_removePID(ProcessID pid) {
+	uint8_t const queueID = schedulingInfo.mlfqClass[pid];
+	if (queueID >= MLFQ_QUEUE_COUNT || !(schedulingInfo.mlfqMembers[queueID] & PROCESS_BIT(pid))) {
+		return;
+	}
+	schedulingInfo.mlfqMembers[queueID] &= ~PROCESS_BIT(pid);
+	ProcessQueue* queue = MLFQ_getQueue(queueID);
+	uint8_t count = (queue->tail + queue->size - queue->head) % queue->size;
+	while (count--) {
+		ProcessID first = pqueue_getFirst(queue);
+		pqueue_dropFirst(queue);
+		if (first != pid) {
+			pqueue_append(queue, first);
+		}
+	}
+}
+
+/*!
+ *  Returns a pointer to the ProcessQueue with index queueID from the
+ *  schedulingInformation.
+ *
+ *  \param queueID Index of the queue.
+ *  \return Pointer to the specific ProcessQueue.
+ */
+ProcessQueue* MLFQ_getQueue(uint8_t queueID) {
+	return &schedulingInfo.queues[queueID];
+}
+
+/*!
+ *  Returns the default number of timeslices for a specific
+ *  ProcessQueue/priority class. Every class gets twice the time slice of the
+ *  class above it, the first class gets the quantum of the strategy.
+ *
+ *  \param queueID The index of the ProcessQueue/the priority class.
+ *  \return Number of timeslices.
+ */
+uint8_t MLFQ_getDefaultTimeslice(uint8_t queueID) {
+	uint16_t slice = (uint16_t)schedulingInfo.quantum[OS_SS_MULTI_LEVEL_FEEDBACK_QUEUE] << queueID;
+	return slice < 0xFF ? slice : 0xFF;
+}
+
+/*!
+ *  Maps a process-priority to a priority class. The two most significant
+ *  bits of the priority are used, 0b11xxxxxx is the highest class (0).
+ *
+ *  \param prio The process-priority.
+ *  \return The index of the ProcessQueue/priority class.
+ */
+uint8_t MLFQ_MapToQueue(Priority prio) {
+	return (MLFQ_QUEUE_COUNT - 1) - (prio >> 6);
+}
+
+/*!
+ *  Initializes the given ProcessQueue with a predefined size. As one slot
+ *  always stays empty, a queue can hold every process except the idle process.
+ *
+ *  \param queue The ProcessQueue to initialize.
+ */
+void pqueue_init(ProcessQueue* queue) {
+	queue->size = MAX_NUMBER_OF_PROCESSES;
+	pqueue_reset(queue);
+}
+
+/*!
+ *  Resets the given ProcessQueue, i.e. drops all ProcessIDs.
+ *
+ *  \param queue The ProcessQueue to reset.
+ */
+void pqueue_reset(ProcessQueue* queue) {
+	queue->head = 0;
+	queue->tail = 0;
+}
+
+/*!
+ *  Checks whether there is a next ProcessID in the given ProcessQueue.
+ *
+ *  \param queue The ProcessQueue to check.
+ *  \return 1 if the queue is not empty, 0 otherwise.
+ */
+uint8_t pqueue_hasNext(ProcessQueue const* queue) {
+	return queue->head != queue->tail;
+}
+
+/*!
+ *  Returns the first ProcessID of the given ProcessQueue.
+ *
+ *  \param queue A non-empty ProcessQueue.
+ *  \return The first ProcessID.
+ */
+ProcessID pqueue_getFirst(ProcessQueue const* queue) {
+	return queue->data[queue->head];
+}
+
+/*!
+ *  Drops the first ProcessID of the given ProcessQueue.
+ *
+ *  \param queue A non-empty ProcessQueue.
+ */
+void pqueue_dropFirst(ProcessQueue* queue) {
+	queue->head = (queue->head + 1) % queue->size;
+}
+
+/*!
+ *  Appends a ProcessID to the given ProcessQueue.
+ *
+ *  \param queue The ProcessQueue to append to.
+ *  \param pid The ProcessID to append.
+ */
+void pqueue_append(ProcessQueue* queue, ProcessID pid) {
+	queue->data[queue->tail] = pid;
+	queue->tail = (queue->tail + 1) % queue->size;
+}
@@ -14,18 +14,56 @@
 #include "os_scheduler.h"
 #include "defines.h"
 
+//! Number of priority classes (i.e. queues) of the MLFQ strategy
+#define MLFQ_QUEUE_COUNT 4
+
+//! Stride of a process with priority 1 (the stride of priority p is STRIDE_ONE / p)
+#define STRIDE_ONE 0x4000
+
+//! Ringbuffer for process queueing
+typedef struct {
+	ProcessID data[MAX_NUMBER_OF_PROCESSES];
+	uint8_t size;
+	uint8_t head;
+	uint8_t tail;
+} ProcessQueue;
+
 //! Structure used to store specific scheduling informations such as a time slice
 typedef struct {
-	uint8_t timeSlice; // quantum
+	uint16_t timeSlice; // quantum
+	uint8_t quantum[SCHEDULING_STRATEGY_MAX]; // ticks per time slice unit of each strategy
 	Age age[MAX_NUMBER_OF_PROCESSES];
+	ProcessQueue queues[MLFQ_QUEUE_COUNT];
+	uint8_t mlfqClass[MAX_NUMBER_OF_PROCESSES]; // queue of each process
+	uint8_t mlfqSlice[MAX_NUMBER_OF_PROCESSES]; // remaining quantum of each process
+	ProcessMask mlfqMembers[MLFQ_QUEUE_COUNT]; // processes in the queue of each class
+	uint16_t stridePass[MAX_NUMBER_OF_PROCESSES]; // virtual time of each process
+	uint16_t stride[MAX_NUMBER_OF_PROCESSES]; // pass increment of each process
+	Priority stridePriority[MAX_NUMBER_OF_PROCESSES]; // priority the stride was computed for
+	uint16_t strideGlobalPass; // virtual time of the last selection
+	ProcessMask strideReady; // processes that were ready at the last selection
 } SchedulingInformation;
 
+#ifndef OS_FIXED_SCHEDULING_STRATEGY
+//! The descriptors of all available strategies, indexed by SchedulingStrategy
+extern SchedulingStrategyDescriptor const* os_schedulingStrategies[SCHEDULING_STRATEGY_MAX];
+#endif
+
+//! Initializes the scheduling information
+void os_initSchedulingInformation(void);
+
 //! Used to reset the SchedulingInfo for one process
 void os_resetProcessSchedulingInformation(ProcessID id);
 
 //! Used to reset the SchedulingInfo for a strategy
 void os_resetSchedulingInformation(SchedulingStrategy strategy);
 
+//! Sets the number of ticks per time slice unit of a strategy
+void os_setStrategyQuantum(SchedulingStrategy strategy, uint8_t quantum);
+
+//! Returns the number of ticks per time slice unit of a strategy
+uint8_t os_getStrategyQuantum(SchedulingStrategy strategy);
+
 //! Even strategy
 ProcessID os_Scheduler_Even(Process const processes[], ProcessID current);
 
@@ -41,4 +79,43 @@ ProcessID os_Scheduler_InactiveAging(Process const processes[], ProcessID curren
 //! RunToCompletion strategy
 ProcessID os_Scheduler_RunToCompletion(Process const processes[], ProcessID current);
 
+//! MultiLevelFeedbackQueue strategy
+ProcessID os_Scheduler_MLFQ(Process const processes[], ProcessID current);
+
+//! Stride strategy
+ProcessID os_Scheduler_Stride(Process const processes[], ProcessID current);
+
+//! EarliestDeadlineFirst strategy
+ProcessID os_Scheduler_EDF(Process const processes[], ProcessID current);
+
+//! Removes the given ProcessID from the ProcessQueues
+void MLFQ_removePID(ProcessID pid);
+
+//! Returns the corresponding ProcessQueue
+ProcessQueue* MLFQ_getQueue(uint8_t queueID);
+
+//! Returns the default number of timeslices for a specific ProcessQueue/priority class
+uint8_t MLFQ_getDefaultTimeslice(uint8_t queueID);
+
+//! Maps a process-priority to a priority class
+uint8_t MLFQ_MapToQueue(Priority prio);
+
+//! Initializes the given ProcessQueue with a predefined size
+void pqueue_init(ProcessQueue* queue);
+
+//! Resets the given ProcessQueue
+void pqueue_reset(ProcessQueue* queue);
+
+//! Checks whether there is a next ProcessID
+uint8_t pqueue_hasNext(ProcessQueue const* queue);
+
+//! Returns the first ProcessID of the given ProcessQueue
+ProcessID pqueue_getFirst(ProcessQueue const* queue);
+
+//! Drops the first ProcessID of the given ProcessQueue
+void pqueue_dropFirst(ProcessQueue* queue);
+
+//! Appends a ProcessID to the given ProcessQueue
+void pqueue_append(ProcessQueue* queue, ProcessID pid);
+
 #endif
@@ -18,6 +18,10 @@
 #define SPI_INS_RDMR 0x05
 #define SPI_INS_WRMR 0x01
 
+//[Operation Modes]
+#define SPI_MODE_BYTE 0
+#define SPI_MODE_SEQUENTIAL 1
+
 void os_spi_init(void);
 uint8_t os_spi_send(uint8_t data);
 uint8_t os_spi_receive();
@@ -0,0 +1,358 @@
+#include "os_sync.h"
+#include "os_scheduler.h"
+#include "os_core.h"
+
+//----------------------------------------------------------------------------
+// Globals
+//----------------------------------------------------------------------------
+
+//! The wait queue every process is blocked on (NULL if it does not wait)
+WaitQueue* os_syncWaitingOn[MAX_NUMBER_OF_PROCESSES];
+
+//! Successor of every waiting process in its wait queue
+ProcessID os_syncNext[MAX_NUMBER_OF_PROCESSES];
+
+//! First mutex of the list of mutexes held by every process
+Mutex* os_syncHeld[MAX_NUMBER_OF_PROCESSES];
+
+//! The mutex every process is blocked on (NULL if it does not wait for a mutex)
+Mutex* os_syncWaitingFor[MAX_NUMBER_OF_PROCESSES];
+
+//! Priority of every process without inherited priorities
+Priority os_syncBasePriority[MAX_NUMBER_OF_PROCESSES];
+
+//----------------------------------------------------------------------------
+// Private functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Appends the current process to a wait queue and blocks it. The caller
+ *  has to yield afterwards (still within its critical section).
+ *
+ *  \param queue The queue the process waits in.
+ */
+static void os_syncBlock(WaitQueue* queue) {
+	ProcessID pid = os_getCurrentProc();
+	os_syncNext[pid] = INVALID_PROCESS;
+	if (queue->head == INVALID_PROCESS) {
+		queue->head = pid;
+	} else {
+		os_syncNext[queue->tail] = pid;
+	}
+	queue->tail = pid;
+	os_syncWaitingOn[pid] = queue;
+
+	os_getProcessSlot(pid)->state = OS_PS_BLOCKED;
+	os_readyMask &= ~PROCESS_BIT(pid);
+}
+
+/*!
+ *  Removes the first process of a wait queue and makes it ready again.
+ *
+ *  \param queue The queue to wake a process from.
+ *  \return The process that was woken up or INVALID_PROCESS if none waited.
+ */
+static ProcessID os_syncWake(WaitQueue* queue) {
+	ProcessID pid = queue->head;
+	if (pid == INVALID_PROCESS) {
+		return INVALID_PROCESS;
+	}
+	queue->head = os_syncNext[pid];
+	os_syncWaitingOn[pid] = NULL;
+	os_syncWaitingFor[pid] = NULL;
+
+	os_getProcessSlot(pid)->state = OS_PS_READY;
+	os_readyMask |= PROCESS_BIT(pid);
+	return pid;
+}
+
+/*!
+ *  Recalculates the priority of a process. It is the maximum of its own
+ *  priority and the (possibly inherited) priorities of all processes that
+ *  wait for one of its mutexes with priority inheritance.
+ *
+ *  \param pid The process to update.
+ */
+static void os_syncUpdatePriority(ProcessID pid) {
+	Priority priority = os_syncBasePriority[pid];
+	for (Mutex* mutex = os_syncHeld[pid]; mutex != NULL; mutex = mutex->nextHeld) {
+		if (!mutex->priorityInheritance) {
+			continue;
+		}
+		for (ProcessID waiter = mutex->waiters.head; waiter != INVALID_PROCESS; waiter = os_syncNext[waiter]) {
+			if (os_getProcessSlot(waiter)->priority > priority) {
+				priority = os_getProcessSlot(waiter)->priority;
+			}
+		}
+	}
+	os_getProcessSlot(pid)->priority = priority;
+	os_procPriority[pid] = priority;
+}
+
+/*!
+ *  Recalculates the priority of a process and passes a change on along the
+ *  chain of mutexes with priority inheritance it waits for, so the owner of
+ *  each of them runs with the priority of every process it holds up. The
+ *  chain is followed for at most MAX_NUMBER_OF_PROCESSES steps, which ends it
+ *  in case of a deadlock.
+ *
+ *  \param pid The first process of the chain.
+ */
+static void os_syncPropagatePriority(ProcessID pid) {
+	for (uint8_t i = 0; i < MAX_NUMBER_OF_PROCESSES; i++) {
+		os_syncUpdatePriority(pid);
+		Mutex const* mutex = os_syncWaitingFor[pid];
+		if (mutex == NULL || !mutex->priorityInheritance) {
+			break;
+		}
+		pid = mutex->owner;
+	}
+}
+
+/*!
+ *  Makes a process the owner of a free mutex.
+ *
+ *  \param mutex The mutex to acquire.
+ *  \param pid The new owner.
+ */
+static void os_syncAcquire(Mutex* mutex, ProcessID pid) {
+	mutex->owner = pid;
+	mutex->nextHeld = os_syncHeld[pid];
+	os_syncHeld[pid] = mutex;
+}
+
+/*!
+ *  Releases a mutex held by any process and hands it directly to the first
+ *  waiting process (if there is one). The priorities of both are calculated
+ *  again from the mutexes they hold afterwards.
+ *
+ *  \param mutex The mutex to release.
+ */
+static void os_syncRelease(Mutex* mutex) {
+	ProcessID owner = mutex->owner;
+	Mutex** link = &os_syncHeld[owner];
+	while (*link != mutex) {
+		link = &(*link)->nextHeld;
+	}
+	*link = mutex->nextHeld;
+	mutex->owner = INVALID_PROCESS;
+
+	ProcessID next = os_syncWake(&mutex->waiters);
+	if (next != INVALID_PROCESS) {
+		os_syncAcquire(mutex, next);
+	}
+	os_syncUpdatePriority(owner);
+	if (next != INVALID_PROCESS) {
+		os_syncUpdatePriority(next);
+	}
+}
+
+//----------------------------------------------------------------------------
+// Function definitions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Removes a process from the wait queue it is blocked on and releases all
+ *  mutexes it holds, so that no other process waits forever for a process
+ *  that does not exist anymore. Must be called with interrupts disabled.
+ *  If the process waited for a mutex with priority inheritance, the owners
+ *  along the chain lose the priority they inherited from it.
+ *
+ *  \param pid The process that is killed.
+ */
+void os_syncReleaseProcess(ProcessID pid) {
+	Mutex const* mutex = os_syncWaitingFor[pid];
+	WaitQueue* queue = os_syncWaitingOn[pid];
+	if (queue != NULL) {
+		ProcessID* link = &queue->head;
+		ProcessID previous = INVALID_PROCESS;
+		while (*link != pid) {
+			previous = *link;
+			link = &os_syncNext[*link];
+		}
+		*link = os_syncNext[pid];
+		if (queue->tail == pid) {
+			queue->tail = previous;
+		}
+		os_syncWaitingOn[pid] = NULL;
+		os_syncWaitingFor[pid] = NULL;
+	}
+	if (mutex != NULL && mutex->priorityInheritance) {
+		os_syncPropagatePriority(mutex->owner);
+	}
+
+	while (os_syncHeld[pid] != NULL) {
+		os_syncRelease(os_syncHeld[pid]);
+	}
+}
+
+/*!
+ *  Sets the own priority of a process. The process keeps the priorities it
+ *  inherits through its mutexes, and a change is passed on to the owners of
+ *  the mutexes it waits for.
+ *
+ *  \param pid The process to set the priority of.
+ *  \param priority The new priority without inherited priorities.
+ */
+void os_syncSetBasePriority(ProcessID pid, Priority priority) {
+	os_enterCriticalSection();
+	os_syncBasePriority[pid] = priority;
+	os_syncPropagatePriority(pid);
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Initializes a mutex as unlocked. With priority inheritance, the owner of
+ *  the mutex runs with the highest priority of all processes that wait for
+ *  it, so a process with a low priority cannot hold up the waiting ones
+ *  for long.
+ *
+ *  \param mutex The mutex to initialize.
+ *  \param priorityInheritance Whether the owner inherits the priorities of the waiting processes.
+ */
+void os_mutexInit(Mutex* mutex, bool priorityInheritance) {
+	mutex->waiters.head = INVALID_PROCESS;
+	mutex->waiters.tail = INVALID_PROCESS;
+	mutex->owner = INVALID_PROCESS;
+	mutex->priorityInheritance = priorityInheritance;
+	mutex->nextHeld = NULL;
+}
+
+/*!
+ *  Acquires a mutex. If it is locked, the process is blocked and appended to
+ *  the wait queue of the mutex until os_mutexUnlock hands it over. Mutexes
+ *  are not recursive. The idle process must always be ready, so it polls
+ *  instead.
+ *
+ *  \param mutex The mutex to acquire.
+ */
+void os_mutexLock(Mutex* mutex) {
+	os_enterCriticalSection();
+	ProcessID pid = os_getCurrentProc();
+
+	if (mutex->owner == pid) {
+		os_error("Mutex already locked by this process");
+	} else if (mutex->owner == INVALID_PROCESS) {
+		os_syncAcquire(mutex, pid);
+	} else if (pid == 0) {
+		while (mutex->owner != INVALID_PROCESS) {
+			os_yield();
+		}
+		os_syncAcquire(mutex, pid);
+	} else {
+		os_syncBlock(&mutex->waiters);
+		os_syncWaitingFor[pid] = mutex;
+		if (mutex->priorityInheritance) {
+			os_syncPropagatePriority(mutex->owner);
+		}
+		// The critical section is kept across the yield, the mutex is
+		// ours as soon as the process runs again
+		os_yield();
+	}
+
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Acquires a mutex if it is not locked.
+ *
+ *  \param mutex The mutex to acquire.
+ *  \return True if the mutex is now held by the current process.
+ */
+bool os_mutexTryLock(Mutex* mutex) {
+	os_enterCriticalSection();
+	bool acquired = mutex->owner == INVALID_PROCESS;
+	if (acquired) {
+		os_syncAcquire(mutex, os_getCurrentProc());
+	}
+	os_leaveCriticalSection();
+	return acquired;
+}
+
+/*!
+ *  Releases a mutex held by the current process. If processes wait for it,
+ *  the first one becomes the new owner and is made ready, but the current
+ *  process keeps running.
+ *
+ *  \param mutex The mutex to release.
+ */
+void os_mutexUnlock(Mutex* mutex) {
+	os_enterCriticalSection();
+	if (mutex->owner != os_getCurrentProc()) {
+		os_error("Mutex not locked by this process");
+	} else {
+		os_syncRelease(mutex);
+	}
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Initializes a semaphore.
+ *
+ *  \param semaphore The semaphore to initialize.
+ *  \param count The number of available units.
+ */
+void os_semaphoreInit(Semaphore* semaphore, uint8_t count) {
+	semaphore->waiters.head = INVALID_PROCESS;
+	semaphore->waiters.tail = INVALID_PROCESS;
+	semaphore->count = count;
+}
+
+/*!
+ *  Takes a unit from a semaphore. If none is available, the process is
+ *  blocked and appended to the wait queue of the semaphore until
+ *  os_semaphoreSignal hands a unit over. The idle process polls instead.
+ *
+ *  \param semaphore The semaphore to take a unit from.
+ */
+void os_semaphoreWait(Semaphore* semaphore) {
+	os_enterCriticalSection();
+
+	if (semaphore->count > 0) {
+		semaphore->count--;
+	} else if (os_getCurrentProc() == 0) {
+		while (semaphore->count == 0) {
+			os_yield();
+		}
+		semaphore->count--;
+	} else {
+		os_syncBlock(&semaphore->waiters);
+		os_yield();
+	}
+
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Takes a unit from a semaphore if one is available.
+ *
+ *  \param semaphore The semaphore to take a unit from.
+ *  \return True if a unit was taken.
+ */
+bool os_semaphoreTryWait(Semaphore* semaphore) {
+	os_enterCriticalSection();
+	bool taken = semaphore->count > 0;
+	if (taken) {
+		semaphore->count--;
+	}
+	os_leaveCriticalSection();
+	return taken;
+}
+
+/*!
+ *  Returns a unit to a semaphore. If processes wait for it, the unit is
+ *  handed to the first one directly, which is made ready.
+ *
+ *  \param semaphore The semaphore to return a unit to.
+ */
+void os_semaphoreSignal(Semaphore* semaphore) {
+	os_enterCriticalSection();
+	if (os_syncWake(&semaphore->waiters) == INVALID_PROCESS) {
+		if (semaphore->count == UINT8_MAX) {
+			os_error("Semaphore overflow");
+		} else {
+			semaphore->count++;
+		}
+	}
+	os_leaveCriticalSection();
+}
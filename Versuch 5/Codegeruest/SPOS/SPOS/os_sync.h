@@ -0,0 +1,82 @@
+/*! \file
+ *  \brief Blocking synchronization primitives.
+ *
+ *  Mutexes and counting semaphores for the coordination of processes. A
+ *  process that cannot acquire one is blocked and queued in the FIFO wait
+ *  queue of the object instead of spinning. Releasing the object hands it
+ *  directly to the first waiter, so a process that was woken up never has
+ *  to compete for it again.
+ *  Priority inheritance also covers nested mutexes: the priority of an owner
+ *  is calculated again on every release from the mutexes it still holds, and
+ *  a boost is passed on along the chain of owners that wait for each other.
+ *  The objects may be placed anywhere in SRAM, but must be initialized
+ *  before they are used and must not be interrupted by an ISR.
+ */
+
+#ifndef _OS_SYNC_H
+#define _OS_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "os_process.h"
+
+//----------------------------------------------------------------------------
+// Types
+//----------------------------------------------------------------------------
+
+//! FIFO queue of the processes that wait for a mutex or semaphore
+typedef struct WaitQueue {
+    ProcessID head;
+    ProcessID tail;
+} WaitQueue;
+
+//! A mutex that is owned by at most one process
+typedef struct Mutex {
+    WaitQueue waiters;
+    ProcessID owner;
+    bool priorityInheritance;
+    struct Mutex* nextHeld;
+} Mutex;
+
+//! A counting semaphore
+typedef struct Semaphore {
+    WaitQueue waiters;
+    uint8_t count;
+} Semaphore;
+
+//----------------------------------------------------------------------------
+// Function headers
+//----------------------------------------------------------------------------
+
+//! Removes a process from all wait queues and releases its mutexes (called by os_kill)
+void os_syncReleaseProcess(ProcessID pid);
+
+//! Sets the priority of a process apart from inherited ones (called by os_setProcessPriority)
+void os_syncSetBasePriority(ProcessID pid, Priority priority);
+
+//! Initializes a mutex, optionally with priority inheritance
+void os_mutexInit(Mutex* mutex, bool priorityInheritance);
+
+//! Acquires a mutex, blocks until it is available
+void os_mutexLock(Mutex* mutex);
+
+//! Acquires a mutex if it is available, never blocks
+bool os_mutexTryLock(Mutex* mutex);
+
+//! Releases a mutex and hands it to the first waiting process
+void os_mutexUnlock(Mutex* mutex);
+
+//! Initializes a semaphore with the given count
+void os_semaphoreInit(Semaphore* semaphore, uint8_t count);
+
+//! Takes a unit from a semaphore, blocks until one is available
+void os_semaphoreWait(Semaphore* semaphore);
+
+//! Takes a unit from a semaphore if one is available, never blocks
+bool os_semaphoreTryWait(Semaphore* semaphore);
+
+//! Returns a unit to a semaphore or hands it to the first waiting process
+void os_semaphoreSignal(Semaphore* semaphore);
+
+#endif
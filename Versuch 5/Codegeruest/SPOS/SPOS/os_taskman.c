@@ -40,6 +40,7 @@ Page specification;
 #if (VERSUCH >= 3)
     #include "os_memory.h"
 #endif
+#include "os_trace.h"
 
 #pragma GCC push_options
 #pragma GCC optimize ("O3")
@@ -80,6 +81,16 @@ Program** os_getProgramSlot(ProgramID);
  */
 #define TM_COMPILE_HEAP_SUPPORT (VERSUCH >= 3)
 
+/*!
+ *  Does the OS record a trace of its context switches?
+ */
+#define TM_COMPILE_TRACE_SUPPORT 1
+
+/*!
+ *  Does the OS account the processor time of the processes?
+ */
+#define TM_COMPILE_CPU_USAGE_SUPPORT 1
+
 /*!
  *  The number of main-pages of the TM. Actually, this is set by
  *  the respective page-handler at runtime.
@@ -98,7 +109,10 @@ Program** os_getProgramSlot(ProgramID);
  *  map-entries should be visible at a time. Be careful when changing this
  *  constant, as it may lead to display overruns if set too high (or odd).
  */
-#define TM_MAP_ENTRIES_PER_PAGE 20
+#define TM_MAP_ENTRIES_PER_PAGE (80 / HEAP_MAP_ENTRY_BITS)
+
+//! Number of bytes that are erased at once before the progress bar is updated
+#define TM_ERASE_BLOCK_SIZE 64
 
 /*!
  *  This is a wrapper for the os_getInput function of the os_input module.
@@ -439,7 +453,9 @@ char PROGMEM const mainLabels[] =
     "Kill Process                   \0"
     "Change Priority                \0"
     "Change Scheduling Strategy     \0"
-    "Heap(s)                        \0";
+    "Heap(s)                        \0"
+    "Switch Trace                   \0"
+    "CPU Usage                      \0";
 
 // Forward declarations for the sub-pages of the root-page.
 static tm_page tm_frontpage;
@@ -461,6 +477,14 @@ static tm_page tm_startProg;
     static tm_page tm_heap;
 #endif
 
+#if TM_COMPILE_TRACE_SUPPORT
+    static tm_page tm_trace;
+#endif
+
+#if TM_COMPILE_CPU_USAGE_SUPPORT
+    static tm_page tm_cpuUsage;
+#endif
+
 static tm_page tm_null;
 
 // A convenience macro to access the stack-history.
@@ -473,22 +497,6 @@ static tm_page tm_null;
 #define MAX5(Xa,X4...) (MAX2(Xa,(MAX4(X4))))
 #define MAX6(Xa,X5...) (MAX2(Xa,(MAX5(X5))))
 
-#if TM_COMPILE_SCHEDULING_SUPPORT
-    /*!
-     *  Why don't we simply use SCHEDULING_STRATEGY_COUNT?
-     *  -> The members of SchedulingStrategy may not be strictly increasing, so there may be
-     *     gaps in the interval [0,SCHEDULING_STRATEGY_COUNT] and more importantly, some
-     *     strategies might have a value >=SCHEDULING_STRATEGY_COUNT.
-     *     Gaps are no problem for the TM engine.
-     */
-    #if VERSUCH >= 5
-        #define SS_MAX_COUNT (MAX6(OS_SS_RUN_TO_COMPLETION, OS_SS_RANDOM, OS_SS_EVEN, OS_SS_ROUND_ROBIN, OS_SS_INACTIVE_AGING, OS_SS_MULTI_LEVEL_FEEDBACK_QUEUE) + 1)
-    #else
-        #define SS_MAX_COUNT (MAX5(OS_SS_RUN_TO_COMPLETION, OS_SS_RANDOM, OS_SS_EVEN, OS_SS_ROUND_ROBIN, OS_SS_INACTIVE_AGING) + 1)
-    #endif
-
-#endif
-
 #if TM_COMPILE_HEAP_SUPPORT
     #define MS_MAX_COUNT (MAX4(OS_MEM_FIRST, OS_MEM_NEXT, OS_MEM_BEST, OS_MEM_WORST) + 1)
 #endif
@@ -522,11 +530,17 @@ static TM_PAGE(tm_rootpage) {
         SUBP(3, tm_priority, os_getCurrentProc(), MAX_NUMBER_OF_PROCESSES)
 #endif
 #if TM_COMPILE_SCHEDULING_SUPPORT
-        SUBP(4, tm_scheduling, os_getSchedulingStrategy(), SS_MAX_COUNT)
+        SUBP(4, tm_scheduling, os_getSchedulingStrategy(), os_getNumberOfSchedulingStrategies())
 #endif
 #if TM_COMPILE_HEAP_SUPPORT
         SUBP(5, tm_heap, 0, TM_HEAP_SUPPORT)
 #endif
+#if TM_COMPILE_TRACE_SUPPORT
+        SUBP(6, tm_trace, 0, OS_TRACE_LENGTH)
+#endif
+#if TM_COMPILE_CPU_USAGE_SUPPORT
+        SUBP(7, tm_cpuUsage, 0, MAX_NUMBER_OF_PROCESSES + 1)
+#endif
 #undef SUBP
         default:
             result->child.call = tm_null;
@@ -768,20 +782,11 @@ make_pagehandler(tm_killProc, tm_killProc_kill, 0, 1, OS_PR_KILL_SELECT, pid, pe
     return procMutator(p, PSTR("Kill"), ~uniqState(OS_PS_UNUSED));
 }
 
-extern ProcessID currentProc;
-bool internalKill(ProcessID pid){
-  ProcessID tmp = currentProc;
-  currentProc = INVALID_PROCESS;
-  bool result = os_kill(pid);
-  currentProc = tmp;
-  return result;
-}
-
 /*!
  *  The page to kill a previously selected process.
  */
 make_pagehandler(tm_killProc_kill, tm_null, 0, 0, OS_PR_KILL, pid, peekStack(1).param) {
-    return procMutatorConfirm(p, PSTR("Killing"), PSTR("Cannot kill #0"), internalKill);
+    return procMutatorConfirm(p, PSTR("Killing"), PSTR("Cannot kill #0"), os_kill);
 }
 
 #endif
@@ -870,9 +875,9 @@ make_pagehandler(tm_priority_changeL, tm_priority_set, 0, 1, OS_PR_PRIORITY, nul
  */
 make_pagehandler(tm_priority_set, tm_null, 0, 0, OS_PR_PRIORITY, pid, peekStack(4).param) {
     lcd_writeProgString(PSTR("Setting priority"));
-    os_getProcessSlot(peekStack(4).param)->priority
-        = ((peekStack(2).param & 0xF) << 4)
-          + ((peekStack(1).param & 0xF));
+    os_setProcessPriority(peekStack(4).param,
+                          ((peekStack(2).param & 0xF) << 4)
+                          + ((peekStack(1).param & 0xF)));
     tm_done();
     lcd_writeProgString(PSTR(", now: "));
     lcd_writeHexByte(os_getProcessSlot(peekStack(4).param)->priority);
@@ -993,17 +998,18 @@ static bool strategyChanger(ParamStack const* p, StrategyNameLookup* names, uint
 
 #if TM_COMPILE_SCHEDULING_SUPPORT
 
-makeStrategyNameLookup(getSchedulingStratNames, 0x18, 0,
-    // 123456789abcdef0123456789ABCDEF0
-    {OS_SS_RUN_TO_COMPLETION,         PSTR("<Run To Completion>    ")},
-    {OS_SS_RANDOM,                    PSTR("<Random>               ")},
-    {OS_SS_EVEN,                      PSTR("<Even>                 ")},
-    {OS_SS_ROUND_ROBIN,               PSTR("<Round Robin>          ")},
-    {OS_SS_INACTIVE_AGING,            PSTR("<Inactive Aging>       ")},
-    #if VERSUCH >= 5
-    {OS_SS_MULTI_LEVEL_FEEDBACK_QUEUE, PSTR("<MLFQ>                 ")},
-    #endif
-)
+/*!
+ *  Looks up the name of a scheduling strategy in the strategy table of the
+ *  scheduler, so strategies registered at runtime are listed as well.
+ *  See StrategyNameLookup.
+ */
+static StrategyNameLookup getSchedulingStratNames;
+static char const* getSchedulingStratNames(uint16_t ss, uint16_t* stringLengthOut) {
+    if (stringLengthOut)
+        *stringLengthOut = 0x18;
+    SchedulingStrategyDescriptor const* const descriptor = os_getSchedulingStrategyDescriptor(ss);
+    return descriptor ? descriptor->name : 0;
+}
 
 /*!
  *  The page to select a scheduling strategy to set.
@@ -1128,7 +1134,22 @@ make_pagehandler(tm_heap_strategy_set, tm_null, 0, 0, OS_PR_ALLOCATION, as, peek
 
 static MemValue derefMap(Heap const* heap, MemAddr usePtr) {
     uint16_t const uOff = usePtr - os_getUseStart(heap);
+#if HEAP_MAP_ENTRY_BITS == 8
+    return heap->driver->read(os_getMapStart(heap) + uOff);
+#else
     return (heap->driver->read(os_getMapStart(heap) + uOff / 2) >> (((~uOff) & 1) << 2)) & 0xF;
+#endif
+}
+
+/*!
+ *  Writes a map entry with as many hex digits as a map entry has.
+ */
+static void writeMapEntry(MemValue entry) {
+#if HEAP_MAP_ENTRY_BITS == 8
+    lcd_writeHexByte(entry);
+#else
+    lcd_writeHexNibble(entry);
+#endif
 }
 
 /*!
@@ -1141,9 +1162,9 @@ make_pagehandler(tm_heap_contents, tm_null, 0, 0, OS_PR_SHOW_HEAP, null, 0) {
     for (i = 0; i < 2; i++) {
         lcd_writeHexWord(addr);
         lcd_writeProgString(PSTR(": "));
-        for (j = 0; j < 16 - 6; j++)
+        for (j = 0; j < 16 - 6; j += HEAP_MAP_ENTRY_BITS / 4)
             if (addr < os_getUseStart(heap) + os_getUseSize(heap)) {
-                lcd_writeHexNibble(derefMap(heap, addr++));
+                writeMapEntry(derefMap(heap, addr++));
             } else {
                 i = j = 16;
             }
@@ -1161,14 +1182,14 @@ make_pagehandler(tm_heap_chunks, tm_null, 0, 0, OS_PR_SHOW_HEAP, null, 0) {
     Heap* const heap = os_lookupHeap(peekStack(2).param);
     uint16_t const addr = os_getUseStart(heap) + peekStack(0).param;
     MemValue const owner = derefMap(heap, addr);
-    if (owner == 0 || owner == 0xF) {
+    if (owner == 0 || owner == HEAP_MAP_CONTINUATION) {
         return false;
     }
     lcd_writeProgString(PSTR("Chunk @"));
     lcd_writeHexWord(addr);
     lcd_writeProgString(PSTR(" ("));
     lcd_writeChar((owner < MAX_NUMBER_OF_PROCESSES) ? '#' : '*');
-    lcd_writeHexNibble(owner);
+    writeMapEntry(owner);
     lcd_writeChar(')');
     lcd_line2();
     lcd_writeProgString(PSTR("Length: ..."));
@@ -1192,26 +1213,114 @@ make_pagehandler(tm_heap_erase2, tm_null, 0, 0, OS_PR_ERASE_HEAP, heapId, peekSt
     lcd_writeProgString(getHeapName(peekStack(3).param));
     lcd_writeProgString(PSTR("..."));
     Heap* const heap = os_lookupHeap(peekStack(3).param);
+    // The other processes keep running, so none of them may allocate or
+    // access the heap before it is erased completely and indexed again
+    os_disablePreemption();
     MemAddr start = os_getMapStart(heap);
     MemAddr end = os_getMapStart(heap) + os_getMapSize(heap);
     MemAddr const mapEnd = end;
     MemAddr ptr;
+    uint16_t step;
     uint8_t lastProgress = 0;
-    for (ptr = start; ptr < end; ptr++) {
-        heap->driver->write(ptr, 0);
-        uint8_t progress = (100ul * (uint16_t)(ptr - start)) / (uint16_t)(end - start);
+    for (ptr = start; ptr < end; ptr += step) {
+        step = (end - ptr < TM_ERASE_BLOCK_SIZE) ? end - ptr : TM_ERASE_BLOCK_SIZE;
+        heap->driver->fill(ptr, 0, step);
+        uint8_t progress = (100ul * (uint16_t)(ptr + step - 1 - start)) / (uint16_t)(end - start);
         if (((uint16_t)progress * 32ul) / 100ul != ((uint16_t)lastProgress * 32ul) / 100ul) {
             lcd_drawBar((lastProgress = progress));
         }
-        if (ptr + 1 == mapEnd) {
-            ptr = (start = os_getUseStart(heap)) - 1;
+        if (ptr + step == mapEnd) {
+            ptr = (start = os_getUseStart(heap)) - step;
             end = os_getUseStart(heap) + os_getUseSize(heap);
         }
     }
+    os_resetHeapIndex(heap);
+    os_enablePreemption();
     tm_done();
     return true;
 }
 
 #endif
 
+#if TM_COMPILE_TRACE_SUPPORT
+
+//! The reasons of a context switch, as displayed in the trace.
+static char PROGMEM const traceReasons[] =
+    "tick \0"
+    "yield\0"
+    "kill \0"
+    "block\0";
+
+/*!
+ *  The page to show the recorded context switches, the newest one first.
+ *  Shows the age, the outgoing and incoming process and the strategy in the
+ *  first line, the reason and the system time in the second line.
+ */
+make_pagehandler(tm_trace, tm_null, 0, 0, OS_PR_SHOW_TRACE, null, 0) {
+    uint16_t const index = peekStack(0).param;
+    TraceEntry entry;
+    if (!os_getTraceEntry(index, &entry)) {
+        return false;
+    }
+    lcd_writeChar('-');
+    lcd_writeDec(index);
+    lcd_writeProgString(PSTR(": #"));
+    lcd_writeDec(entry.from);
+    lcd_writeProgString(PSTR(">#"));
+    lcd_writeDec(entry.to);
+    lcd_writeProgString(PSTR(" S"));
+    lcd_writeDec(entry.strategy);
+    lcd_line2();
+    lcd_writeProgString(traceReasons + 6 * entry.reason);
+    lcd_writeChar(' ');
+    lcd_write32bitHex(entry.time);
+    return true;
+}
+
+#endif
+
+#if TM_COMPILE_CPU_USAGE_SUPPORT
+
+/*!
+ *  The page to show the share of the processor time every process used since
+ *  the accounting was reset, together with the number of switches to it.
+ *  The last page shows the share of the scheduler itself.
+ */
+make_pagehandler(tm_cpuUsage, tm_null, 0, 0, OS_PR_SHOW_CPU_USAGE, null, 0) {
+    uint16_t const page = peekStack(0).param;
+    Time const percent = os_getAccountingTime() / 100;
+    Time time;
+    if (page < MAX_NUMBER_OF_PROCESSES) {
+        if (os_getProcessSlot(page)->state == OS_PS_UNUSED) {
+            return false;
+        }
+        lcd_writeProgString(PSTR("Proc. #"));
+        lcd_writeDec(page);
+        time = os_getProcessCpuTime(page);
+    } else {
+        lcd_writeProgString(PSTR("Scheduler"));
+        time = os_getSchedulerTime();
+    }
+    lcd_writeProgString(PSTR(": "));
+    lcd_writeDec(percent ? (uint16_t)(time / percent) : 0);
+    lcd_writeChar('%');
+    if (page < MAX_NUMBER_OF_PROCESSES) {
+        lcd_line2();
+        lcd_writeDec(os_getProcessSwitches(page));
+        lcd_writeProgString(PSTR(" switches"));
+    }
+#if OS_CYCLE_PROBE
+    else {
+        lcd_line2();
+        lcd_writeProgString(PSTR("Chk "));
+        lcd_writeDec(os_getProbeCycles(OS_PROBE_STACK_CHECK));
+        lcd_writeProgString(PSTR(" Sel "));
+        lcd_writeDec(os_getProbeCycles(OS_PROBE_SELECT));
+    }
+#endif
+    return true;
+}
+
+#endif
+
 #pragma GCC pop_options
\ No newline at end of file
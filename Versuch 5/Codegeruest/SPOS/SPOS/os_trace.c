@@ -0,0 +1,72 @@
+#include "os_trace.h"
+
+#if OS_TRACE_LENGTH & (OS_TRACE_LENGTH - 1)
+#error "OS_TRACE_LENGTH must be a power of two"
+#endif
+
+//! The ring buffer of recorded switches
+TraceEntry os_trace[OS_TRACE_LENGTH];
+
+//! Index of the slot the next switch is written to
+uint8_t os_traceNext;
+
+//! Number of valid entries in the ring buffer
+uint8_t os_traceCount;
+
+/*!
+ *  Records a context switch, overwriting the oldest entry if the buffer is
+ *  full. Must be called with interrupts disabled.
+ *
+ *  \param time The system time of the switch.
+ *  \param from The process that was running before.
+ *  \param to The process that runs now.
+ *  \param strategy The scheduling strategy that made the decision.
+ *  \param reason Why the scheduler was entered.
+ */
+void os_traceSwitch(Time time, ProcessID from, ProcessID to, SchedulingStrategy strategy, SwitchReason reason) {
+	TraceEntry* entry = &os_trace[os_traceNext];
+	entry->time = time;
+	entry->from = from;
+	entry->to = to;
+	entry->strategy = strategy;
+	entry->reason = reason;
+	os_traceNext = (os_traceNext + 1) & (OS_TRACE_LENGTH - 1);
+	if (os_traceCount < OS_TRACE_LENGTH) {
+		os_traceCount++;
+	}
+}
+
+/*!
+ *  \return The number of recorded switches (at most OS_TRACE_LENGTH).
+ */
+uint8_t os_getTraceLength(void) {
+	return os_traceCount;
+}
+
+/*!
+ *  Reads a recorded switch. The copy is taken in a critical section, so the
+ *  entry is consistent even if the scheduler records a switch meanwhile.
+ *
+ *  \param index Age of the entry, 0 is the most recent switch.
+ *  \param entry Where to store the entry.
+ *  \return False if there is no entry with this index.
+ */
+bool os_getTraceEntry(uint8_t index, TraceEntry* entry) {
+	os_enterCriticalSection();
+	bool valid = index < os_traceCount;
+	if (valid) {
+		*entry = os_trace[(os_traceNext - 1 - index) & (OS_TRACE_LENGTH - 1)];
+	}
+	os_leaveCriticalSection();
+	return valid;
+}
+
+/*!
+ *  Drops all recorded switches.
+ */
+void os_clearTrace(void) {
+	os_enterCriticalSection();
+	os_traceNext = 0;
+	os_traceCount = 0;
+	os_leaveCriticalSection();
+}
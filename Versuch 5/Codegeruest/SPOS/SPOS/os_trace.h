@@ -0,0 +1,56 @@
+/*! \file
+ *  \brief Trace of the context switches done by the scheduler.
+ *
+ *  The scheduler records every context switch in a ring buffer that holds
+ *  the last OS_TRACE_LENGTH switches. Recording a switch only copies a few
+ *  bytes, so the trace may be left enabled.
+ */
+
+#ifndef _OS_TRACE_H
+#define _OS_TRACE_H
+
+#include <stdint.h>
+
+#include "defines.h"
+#include "util.h"
+#include "os_process.h"
+#include "os_scheduler.h"
+
+//----------------------------------------------------------------------------
+// Types
+//----------------------------------------------------------------------------
+
+//! The reason why the scheduler switched to another process
+typedef enum SwitchReason {
+    OS_SR_TICK,
+    OS_SR_YIELD,
+    OS_SR_KILL,
+    OS_SR_BLOCK
+} SwitchReason;
+
+//! A recorded context switch
+typedef struct TraceEntry {
+    Time time;
+    ProcessID from;
+    ProcessID to;
+    SchedulingStrategy strategy;
+    SwitchReason reason;
+} TraceEntry;
+
+//----------------------------------------------------------------------------
+// Function headers
+//----------------------------------------------------------------------------
+
+//! Records a context switch (called by the scheduler)
+void os_traceSwitch(Time time, ProcessID from, ProcessID to, SchedulingStrategy strategy, SwitchReason reason);
+
+//! Returns the number of recorded switches (at most OS_TRACE_LENGTH)
+uint8_t os_getTraceLength(void);
+
+//! Copies the index-th most recent switch (0 is the newest) to entry
+bool os_getTraceEntry(uint8_t index, TraceEntry* entry);
+
+//! Drops all recorded switches
+void os_clearTrace(void);
+
+#endif
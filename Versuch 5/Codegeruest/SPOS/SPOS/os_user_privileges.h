@@ -53,7 +53,9 @@ typedef enum {
     OS_PR_ALLOCATION_SELECT,   //!< Request to show the allocation strategy selection for the previously selected heap.
     OS_PR_ALLOCATION,          //!< Request to set the allocation strategy of the selected heap to the newly chosen.
     OS_PR_SHOW_HEAP,           //!< Request to open the heap sub menu for the selected heap.
-    OS_PR_ERASE_HEAP           //!< Request to completely erase the contents (map and use) of the selected heap.
+    OS_PR_ERASE_HEAP,          //!< Request to completely erase the contents (map and use) of the selected heap.
+    OS_PR_SHOW_TRACE,          //!< Request to show the trace of the recent context switches.
+    OS_PR_SHOW_CPU_USAGE       //!< Request to show the processor usage of the processes.
 } PermissionRequest;
 
 //! The argument of the request.
@@ -28,6 +28,9 @@ extern Time os_coarseSystemTime;
 
 #define TC0_PRESCALER 256
 
+//! Prescaler of timer 2 (scheduler)
+#define TC2_PRESCALER 1024
+
 Time getSystemTime(void);
 
 //----------------------------------------------------------------------------
@@ -144,4 +147,70 @@ void delayMs(uint16_t ms);
         "reti                                \n\t" \
     );
 
+/*!
+ *  \brief Saves the reduced register context of a voluntary context switch
+ *
+ *  Only usable at the very beginning of a naked function that is entered by a
+ *  regular call. The caller does not expect the call-clobbered registers
+ *  (r0, r18-r27, r30, r31) to survive the call, so only SREG and the
+ *  call-saved registers (r2-r17, r28, r29) are pushed. r1 is zero anyway as
+ *  mandated by the calling convention. The return address pushed by the call
+ *  completes the frame.
+ */
+#define saveYieldContext() \
+    __asm__ volatile( \
+        "in    r0, __SREG__                  \n\t" \
+        "cli                                 \n\t" \
+        "push  r0                            \n\t" \
+        "push  r2                            \n\t" \
+        "push  r3                            \n\t" \
+        "push  r4                            \n\t" \
+        "push  r5                            \n\t" \
+        "push  r6                            \n\t" \
+        "push  r7                            \n\t" \
+        "push  r8                            \n\t" \
+        "push  r9                            \n\t" \
+        "push  r10                           \n\t" \
+        "push  r11                           \n\t" \
+        "push  r12                           \n\t" \
+        "push  r13                           \n\t" \
+        "push  r14                           \n\t" \
+        "push  r15                           \n\t" \
+        "push  r16                           \n\t" \
+        "push  r17                           \n\t" \
+        "push  r28                           \n\t" \
+        "push  r29                           \n\t" \
+    );
+
+/*!
+ *  \brief Restores a register context saved by saveYieldContext
+ *
+ *  Returns to the caller of the function that saved the context with a plain
+ *  ret, so the global interrupt flag is exactly what it was before the switch.
+ */
+#define restoreYieldContext() \
+    __asm__ volatile( \
+        "pop  r29                            \n\t" \
+        "pop  r28                            \n\t" \
+        "pop  r17                            \n\t" \
+        "pop  r16                            \n\t" \
+        "pop  r15                            \n\t" \
+        "pop  r14                            \n\t" \
+        "pop  r13                            \n\t" \
+        "pop  r12                            \n\t" \
+        "pop  r11                            \n\t" \
+        "pop  r10                            \n\t" \
+        "pop  r9                             \n\t" \
+        "pop  r8                             \n\t" \
+        "pop  r7                             \n\t" \
+        "pop  r6                             \n\t" \
+        "pop  r5                             \n\t" \
+        "pop  r4                             \n\t" \
+        "pop  r3                             \n\t" \
+        "pop  r2                             \n\t" \
+        "pop  r0                             \n\t" \
+        "out  __SREG__, r0                   \n\t" \
+        "ret                                 \n\t" \
+    );
+
 #endif
@@ -0,0 +1,90 @@
+//-----------------------------------------------------
+//          TestSuite: Free Block Index
+//-----------------------------------------------------
+// Tests if allocations are still correct when a heap
+// has more free blocks than its index can hold
+// (HEAP_FREE_BLOCKS), so the map has to be scanned,
+// and if the index is used again afterwards.
+//-----------------------------------------------------
+
+#include "lcd.h"
+#include "util.h"
+#include "os_core.h"
+#include "os_scheduler.h"
+#include "os_memory.h"
+#include "os_input.h"
+
+#include <avr/interrupt.h>
+
+#define DELAY 100
+
+//! Number of chunks, every other one is freed to leave more holes than the index holds
+#define CHUNKS (2 * HEAP_FREE_BLOCKS + 2)
+
+//! Size of each chunk
+#define CHUNK_SIZE 2
+
+void testHeap(Heap* heap) {
+    MemAddr chunks[CHUNKS];
+
+    lcd_clear();
+    lcd_writeString(heap->name);
+    lcd_writeProgString(PSTR(": "));
+    os_setAllocationStrategy(heap, OS_MEM_FIRST);
+    for (uint8_t i = 0; i < CHUNKS; i++) {
+        chunks[i] = os_malloc(heap, CHUNK_SIZE);
+        if (!chunks[i]) {
+            os_error("Not enough memory");
+        }
+    }
+    for (uint8_t i = 1; i < CHUNKS; i++) {
+        if (chunks[i] != chunks[i - 1] + CHUNK_SIZE) {
+            os_error("Chunks not adjacent");
+        }
+    }
+    lcd_writeChar('.');
+
+    // Leaves CHUNKS / 2 holes in front of the rest of the heap
+    for (uint8_t i = 0; i < CHUNKS; i += 2) {
+        os_free(heap, chunks[i]);
+    }
+    lcd_writeChar('.');
+
+    // The holes have to be found in order by scanning the map
+    for (uint8_t i = 0; i < CHUNKS; i += 2) {
+        if (os_malloc(heap, CHUNK_SIZE) != chunks[i]) {
+            os_error("Hole not found");
+        }
+    }
+    lcd_writeChar('.');
+
+    // With a single free block the index is built again and has to match the map
+    for (uint8_t i = 0; i < CHUNKS; i++) {
+        os_free(heap, chunks[i]);
+    }
+    if (os_malloc(heap, CHUNKS * CHUNK_SIZE) != chunks[0]) {
+        os_error("Index rebuilt wrong");
+    }
+    os_free(heap, chunks[0]);
+    lcd_writeProgString(PSTR(" ok"));
+    delayMs(10 * DELAY);
+}
+
+PROGRAM(1, AUTOSTART) {
+    for (uint8_t i = 0; i < os_getHeapListLength(); i++) {
+        testHeap(os_lookupHeap(i));
+    }
+
+    // SUCCESS
+    lcd_clear();
+    lcd_writeProgString(PSTR("ALL TESTS PASSED"));
+    lcd_line2();
+    lcd_writeProgString(PSTR(" PLEASE CONFIRM!"));
+    os_waitForInput();
+    os_waitForNoInput();
+    lcd_clear();
+    lcd_writeProgString(PSTR("WAITING FOR"));
+    lcd_line2();
+    lcd_writeProgString(PSTR("TERMINATION"));
+    delayMs(1000);
+}